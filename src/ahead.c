@@ -0,0 +1,83 @@
+#include "ahead.h"
+#include <string.h>
+
+/* =========================
+   FRAME RING
+========================= */
+void frame_ring_init(FrameRing *r) {
+    memset(r->data, 0, sizeof(r->data));
+    SDL_AtomicSet(&r->head, 0);
+    SDL_AtomicSet(&r->tail, 0);
+}
+
+int frame_ring_fill(FrameRing *r) {
+    return (int)((Uint32)SDL_AtomicGet(&r->head) - (Uint32)SDL_AtomicGet(&r->tail));
+}
+
+/* frames are interleaved L/R pairs */
+static void ring_copy(int16_t *dst, const int16_t *src, int frames) {
+    memcpy(dst, src, (size_t)frames * 2 * sizeof(int16_t));
+}
+
+void frame_ring_write(FrameRing *r, const int16_t *src, int frames) {
+    Uint32 head = (Uint32)SDL_AtomicGet(&r->head);
+    int pos = (int)(head & (AHEAD_RING_FRAMES - 1));
+    int first = AHEAD_RING_FRAMES - pos;
+    if (first > frames) first = frames;
+
+    /* at most two pieces, around the end of the ring */
+    ring_copy(r->data + pos * 2, src, first);
+    ring_copy(r->data, src + first * 2, frames - first);
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&r->head, (int)(head + (Uint32)frames));
+}
+
+int frame_ring_read(FrameRing *r, int16_t *dst, int frames) {
+    Uint32 tail = (Uint32)SDL_AtomicGet(&r->tail);
+    int fill = (int)((Uint32)SDL_AtomicGet(&r->head) - tail);
+    if (frames > fill) frames = fill;
+
+    SDL_MemoryBarrierAcquire();
+    int pos = (int)(tail & (AHEAD_RING_FRAMES - 1));
+    int first = AHEAD_RING_FRAMES - pos;
+    if (first > frames) first = frames;
+
+    ring_copy(dst, r->data + pos * 2, first);
+    ring_copy(dst + first * 2, r->data, frames - first);
+
+    SDL_AtomicSet(&r->tail, (int)(tail + (Uint32)frames));
+    return frames;
+}
+
+/* =========================
+   EVENT QUEUE
+========================= */
+void event_queue_init(EventQueue *q) {
+    SDL_AtomicSet(&q->head, 0);
+    SDL_AtomicSet(&q->tail, 0);
+}
+
+int event_push(EventQueue *q, const Event *e) {
+    int head = SDL_AtomicGet(&q->head);
+    if (head - SDL_AtomicGet(&q->tail) >= EVENT_QUEUE_SIZE)
+        return -1;
+
+    q->ev[head & (EVENT_QUEUE_SIZE - 1)] = *e;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&q->head, head + 1);
+    return 0;
+}
+
+const Event *event_peek(EventQueue *q) {
+    int tail = SDL_AtomicGet(&q->tail);
+    if (tail == SDL_AtomicGet(&q->head))
+        return NULL;
+
+    SDL_MemoryBarrierAcquire();
+    return &q->ev[tail & (EVENT_QUEUE_SIZE - 1)];
+}
+
+void event_pop(EventQueue *q) {
+    SDL_AtomicAdd(&q->tail, 1);
+}
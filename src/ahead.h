@@ -0,0 +1,54 @@
+#pragma once
+#include <SDL.h>
+#include <stdint.h>
+
+/* =========================
+   RENDER-AHEAD
+   Two single-producer / single-consumer queues between threads, both
+   wait-free on either side:
+   - FrameRing carries finished S16 stereo frames from the render thread
+     to the audio callback, which only copies them out.
+   - EventQueue carries UI events to whichever thread runs the engine,
+     stamped with the frame they should land on.
+   Frame counts are free-running 32-bit counters; compare them through
+   a signed difference so they survive wrapping.
+========================= */
+#define AHEAD_RING_FRAMES 16384            /* power of two */
+#define EVENT_QUEUE_SIZE  256              /* power of two */
+
+typedef struct {
+    int16_t data[AHEAD_RING_FRAMES * 2];
+    SDL_atomic_t head;          /* frames written by the render thread */
+    SDL_atomic_t tail;          /* frames read by the audio callback */
+} FrameRing;
+
+void frame_ring_init(FrameRing *r);
+int  frame_ring_fill(FrameRing *r);
+
+/* render thread only; the caller checks there is room */
+void frame_ring_write(FrameRing *r, const int16_t *src, int frames);
+
+/* audio thread only; returns the frames actually copied */
+int  frame_ring_read(FrameRing *r, int16_t *dst, int frames);
+
+typedef struct {
+    int type;
+    Uint32 frame;               /* engine frame to apply it on */
+    int a, b;
+    float f;
+} Event;
+
+typedef struct {
+    Event ev[EVENT_QUEUE_SIZE];
+    SDL_atomic_t head;          /* next slot the UI fills */
+    SDL_atomic_t tail;          /* next slot the engine applies */
+} EventQueue;
+
+void event_queue_init(EventQueue *q);
+
+/* UI thread; returns -1 when the queue is full */
+int  event_push(EventQueue *q, const Event *e);
+
+/* engine thread; NULL when empty. The event stays queued until popped */
+const Event *event_peek(EventQueue *q);
+void event_pop(EventQueue *q);
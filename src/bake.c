@@ -0,0 +1,306 @@
+#define SDL_MAIN_HANDLED
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bank.h"
+#include "synth.h"
+#include "wav.h"
+
+/* =========================
+   SOUND BANK BAKER
+   Renders a list of synth_trigger specs on every core, one Synth per
+   worker, and packs the results into a single mmap-able bank.
+
+   spec file, one sound per line ('#' starts a comment):
+     <freq> <square|triangle|noise> <amp decay per sample> [name]
+========================= */
+#define BAKE_MAX_SPECS  4096
+#define BAKE_MAX_FRAMES (SAMPLE_RATE * 10)
+#define BAKE_MAX_WORKERS 64
+
+typedef struct {
+    float freq;
+    int waveform;
+    float decay;
+    char name[48];
+
+    int line;       /* in the spec file, for messages */
+
+    float *pcm;     /* filled by a worker */
+    int frames;
+    int cut;        /* still sounding at BAKE_MAX_FRAMES */
+} Spec;
+
+static Spec specs[BAKE_MAX_SPECS];
+static int num_specs = 0;
+static SDL_atomic_t next_spec;
+
+static int parse_waveform(const char *s) {
+    if (strcmp(s, "square") == 0   || strcmp(s, "0") == 0) return 0;
+    if (strcmp(s, "triangle") == 0 || strcmp(s, "1") == 0) return 1;
+    if (strcmp(s, "noise") == 0    || strcmp(s, "2") == 0) return 2;
+    return -1;
+}
+
+static int load_specs(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("cannot open %s\n", path);
+        return -1;
+    }
+
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+
+        char *hash = strchr(line, '#');
+        if (hash) *hash = 0;
+
+        /* blank and comment-only lines */
+        char word[2];
+        if (sscanf(line, "%1s", word) == EOF)
+            continue;
+
+        if (num_specs == BAKE_MAX_SPECS) {
+            printf("%s:%d: more than %d sounds, rest ignored\n", path, lineno, BAKE_MAX_SPECS);
+            break;
+        }
+
+        char wf[32];
+        Spec *s = &specs[num_specs];
+        s->name[0] = 0;
+        s->line = lineno;
+        int n = sscanf(line, "%f %31s %f %47s", &s->freq, wf, &s->decay, s->name);
+
+        if (n < 3 || (s->waveform = parse_waveform(wf)) < 0 ||
+            s->decay <= 0.0f || s->decay >= 1.0f) {
+            printf("%s:%d: expected <freq> <square|triangle|noise> <decay 0..1>\n",
+                   path, lineno);
+            fclose(f);
+            return -1;
+        }
+
+        num_specs++;
+    }
+
+    fclose(f);
+    return 0;
+}
+
+/* =========================
+   WORKERS
+========================= */
+static int worker(void *ud) {
+    Synth synth;
+    float *scratch = malloc(BAKE_MAX_FRAMES * sizeof(float));
+    if (!scratch)
+        return -1;
+
+    for (;;) {
+        int i = SDL_AtomicAdd(&next_spec, 1);
+        if (i >= num_specs)
+            break;
+
+        Spec *s = &specs[i];
+
+        synth_init(&synth);
+        synth_trigger_decay(&synth, s->freq, s->waveform, s->decay);
+
+        int n = 0;
+        while (n < BAKE_MAX_FRAMES && synth_active(&synth))
+            scratch[n++] = synth_sample(&synth);
+
+        s->pcm = malloc((n ? n : 1) * sizeof(float));
+        if (!s->pcm) {
+            free(scratch);
+            return -1;
+        }
+        memcpy(s->pcm, scratch, n * sizeof(float));
+        s->frames = n;
+        s->cut = synth_active(&synth);
+    }
+
+    free(scratch);
+    return 0;
+}
+
+/* =========================
+   OUTPUT
+========================= */
+static int16_t to_s16(float x) {
+    if (x > 1.0f) x = 1.0f;
+    if (x < -1.0f) x = -1.0f;
+    return (int16_t)(x * 32767);
+}
+
+static int write_pcm(FILE *f, const float *pcm, int frames, int format) {
+    if (format == BANK_F32)
+        return fwrite(pcm, sizeof(float), frames, f) == (size_t)frames ? 0 : -1;
+
+    int16_t buf[1024];
+    for (int i = 0; i < frames; i += 1024) {
+        int n = frames - i < 1024 ? frames - i : 1024;
+        for (int k = 0; k < n; k++)
+            buf[k] = to_s16(pcm[i + k]);
+        if (fwrite(buf, sizeof(int16_t), n, f) != (size_t)n)
+            return -1;
+    }
+    return 0;
+}
+
+static int write_bank(const char *path, int format) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        printf("cannot create %s\n", path);
+        return -1;
+    }
+
+    /* one big buffer instead of many small writes */
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+
+    int bytes = (format == BANK_F32) ? 4 : 2;
+    static BankEntry entries[BAKE_MAX_SPECS];
+
+    uint64_t off = sizeof(BankHeader) + num_specs * sizeof(BankEntry);
+    for (int i = 0; i < num_specs; i++) {
+        off = (off + BANK_ALIGN - 1) & ~(uint64_t)(BANK_ALIGN - 1);
+        entries[i].offset = off;
+        entries[i].frames = specs[i].frames;
+        entries[i].reserved = 0;
+        off += (uint64_t)specs[i].frames * bytes;
+    }
+
+    BankHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = BANK_MAGIC;
+    h.version = BANK_VERSION;
+    h.sample_rate = SAMPLE_RATE;
+    h.format = format;
+    h.count = num_specs;
+    h.file_size = off;
+
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+             fwrite(entries, sizeof(BankEntry), num_specs, f) == (size_t)num_specs;
+
+    uint64_t pos = sizeof(BankHeader) + num_specs * sizeof(BankEntry);
+    static const uint8_t zero[BANK_ALIGN];
+    for (int i = 0; ok && i < num_specs; i++) {
+        if (entries[i].offset > pos)
+            ok = fwrite(zero, 1, entries[i].offset - pos, f) == entries[i].offset - pos;
+        ok = ok && write_pcm(f, specs[i].pcm, specs[i].frames, format) == 0;
+        pos = entries[i].offset + (uint64_t)specs[i].frames * bytes;
+    }
+
+    if (fclose(f) != 0)
+        ok = 0;
+    if (!ok)
+        printf("write failed: %s\n", path);
+    return ok ? 0 : -1;
+}
+
+static int write_wavs(const char *dir, int format) {
+    int wav_fmt = (format == BANK_F32) ? WAV_FLOAT : WAV_PCM16;
+    int bytes = (format == BANK_F32) ? 4 : 2;
+
+    for (int i = 0; i < num_specs; i++) {
+        char path[512];
+        if (specs[i].name[0])
+            snprintf(path, sizeof(path), "%s/%03d_%s.wav", dir, i, specs[i].name);
+        else
+            snprintf(path, sizeof(path), "%s/%03d.wav", dir, i);
+
+        FILE *f = fopen(path, "wb");
+        if (!f) {
+            printf("cannot create %s\n", path);
+            return -1;
+        }
+
+        int ok = wav_write_header(f, SAMPLE_RATE, 1, wav_fmt,
+                                  (uint32_t)specs[i].frames * bytes) == 0 &&
+                 write_pcm(f, specs[i].pcm, specs[i].frames, format) == 0;
+        if (fclose(f) != 0 || !ok) {
+            printf("write failed: %s\n", path);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* =========================
+   MAIN
+========================= */
+static void usage(void) {
+    printf("usage: bake [--s16] [--wav DIR] [--jobs N] SPECS BANK\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *spec_path = NULL;
+    const char *bank_path = NULL;
+    const char *wav_dir = NULL;
+    int format = BANK_F32;
+    int jobs = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--s16") == 0)                    format = BANK_S16;
+        else if (strcmp(argv[i], "--wav") == 0 && i + 1 < argc)  wav_dir = argv[++i];
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobs = atoi(argv[++i]);
+        else if (!spec_path)                                   spec_path = argv[i];
+        else if (!bank_path)                                   bank_path = argv[i];
+        else { usage(); return 1; }
+    }
+    if (!spec_path || !bank_path) {
+        usage();
+        return 1;
+    }
+
+    if (load_specs(spec_path) != 0)
+        return 1;
+
+    if (jobs <= 0) jobs = SDL_GetCPUCount();
+    if (jobs > BAKE_MAX_WORKERS) jobs = BAKE_MAX_WORKERS;
+    if (jobs > num_specs) jobs = num_specs;
+
+    Uint64 t0 = SDL_GetPerformanceCounter();
+
+    SDL_AtomicSet(&next_spec, 0);
+    SDL_Thread *threads[BAKE_MAX_WORKERS];
+    for (int i = 0; i < jobs; i++)
+        threads[i] = SDL_CreateThread(worker, "bake", NULL);
+
+    int failed = 0;
+    for (int i = 0; i < jobs; i++) {
+        int status = -1;
+        if (threads[i])
+            SDL_WaitThread(threads[i], &status);
+        if (status != 0)
+            failed = 1;
+    }
+    if (failed) {
+        printf("render failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    double ms = (double)(SDL_GetPerformanceCounter() - t0) * 1000.0 /
+                (double)SDL_GetPerformanceFrequency();
+    printf("rendered %d sounds on %d workers in %.1f ms\n", num_specs, jobs, ms);
+
+    for (int i = 0; i < num_specs; i++) {
+        if (specs[i].cut)
+            printf("%s:%d: warning: cut at %d s, decay %g is too slow to die out\n",
+                   spec_path, specs[i].line, BAKE_MAX_FRAMES / SAMPLE_RATE, specs[i].decay);
+    }
+
+    if (write_bank(bank_path, format) != 0)
+        return 1;
+    if (wav_dir && write_wavs(wav_dir, format) != 0)
+        return 1;
+
+    for (int i = 0; i < num_specs; i++)
+        free(specs[i].pcm);
+    return 0;
+}
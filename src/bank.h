@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+
+/* =========================
+   SOUND BANK FILE
+   Written by the bake tool, laid out so a game can mmap the file and
+   read sounds in place:
+
+     BankHeader
+     BankEntry[count]
+     PCM data, each sound starting on a BANK_ALIGN boundary
+
+   Sounds are mono at header.sample_rate. All fields are little-endian.
+========================= */
+#define BANK_MAGIC   0x4B425357u   /* "WSBK" */
+#define BANK_VERSION 1
+#define BANK_ALIGN   16
+
+#define BANK_F32 0
+#define BANK_S16 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t format;        /* BANK_F32 or BANK_S16 */
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t file_size;
+} BankHeader;
+
+typedef struct {
+    uint64_t offset;        /* from the start of the file */
+    uint32_t frames;
+    uint32_t reserved;
+} BankEntry;
+
+static inline const BankEntry *bank_entries(const void *base) {
+    return (const BankEntry *)((const uint8_t *)base + sizeof(BankHeader));
+}
+
+static inline const void *bank_sound(const void *base, uint32_t i) {
+    return (const uint8_t *)base + bank_entries(base)[i].offset;
+}
@@ -0,0 +1,142 @@
+#include "env.h"
+#include <math.h>
+
+void env_rate_init(EnvRate *r, float k) {
+    float c = 1.0f - k;
+    float p = 1.0f;
+
+    r->k = k;
+    r->log_c = logf(c);
+    for (int i = 0; i < ENV_MAX_BLOCK; i++) {
+        p *= c;
+        r->pow[i] = p;
+    }
+}
+
+/* frames until a one-pole distance d has shrunk below eps */
+static int one_pole_frames(float d, float eps, const EnvRate *r) {
+    d = fabsf(d);
+    if (d < eps)
+        return 0;
+
+    float n = ceilf(logf(eps / d) / r->log_c);
+    return (n < 1e9f) ? (int)n : 1000000000;
+}
+
+static void one_pole_fill(float *out, float x0, float t, const EnvRate *r, int frames) {
+    float d = x0 - t;
+    for (int i = 0; i < frames; i++)
+        out[i] = t + d * r->pow[i];
+}
+
+/* =========================
+   ADSR
+========================= */
+void adsr_start(Adsr *e) {
+    e->stage = ENV_ATTACK;
+    e->x = 0.0f;
+    e->release = 0;
+}
+
+void adsr_release(Adsr *e, const EnvRate *rate) {
+    if (e->stage == ENV_IDLE)
+        return;
+    e->stage = ENV_RELEASE;
+    e->release = rate;
+}
+
+int adsr_block(Adsr *e, const AdsrShape *s, float *out, int frames) {
+    int done = 0;
+
+    while (done < frames) {
+        float *o = out + done;
+        int left = frames - done;
+
+        switch (e->stage) {
+        case ENV_ATTACK:
+        case ENV_DECAY: {
+            int attack = (e->stage == ENV_ATTACK);
+            const EnvRate *r = attack ? s->attack : s->decay;
+            float t = attack ? s->peak : s->sustain;
+
+            int n = one_pole_frames(e->x - t, s->settle, r);
+            if (n > left) {
+                one_pole_fill(o, e->x, t, r, left);
+                e->x = o[left - 1];
+                return frames;
+            }
+
+            one_pole_fill(o, e->x, t, r, n);
+            done += n;
+            e->x = t;
+            e->stage = attack ? ENV_DECAY : ENV_SUSTAIN;
+            break;
+        }
+
+        case ENV_SUSTAIN:
+            e->x = s->sustain;
+            for (int i = 0; i < left; i++)
+                o[i] = e->x;
+            return frames;
+
+        case ENV_RELEASE: {
+            /* the frame that drops below floor is still played */
+            int n = one_pole_frames(e->x, s->floor, e->release);
+            if (n < 1) n = 1;
+
+            if (n > left) {
+                one_pole_fill(o, e->x, 0.0f, e->release, left);
+                e->x = o[left - 1];
+                return frames;
+            }
+
+            one_pole_fill(o, e->x, 0.0f, e->release, n);
+            e->x = 0.0f;
+            e->stage = ENV_IDLE;
+            return done + n;
+        }
+
+        default:
+            return done;
+        }
+    }
+    return done;
+}
+
+/* =========================
+   PITCH
+========================= */
+void pitch_env_start(PitchEnv *p, float glide, float sweep) {
+    p->glide = glide;
+    p->sweep = sweep;
+    p->steady = 0;
+}
+
+void pitch_env_block(PitchEnv *p, const PitchShape *s, float *out, int frames) {
+    if (frames <= 0)
+        return;
+
+    if (p->steady) {
+        for (int i = 0; i < frames; i++)
+            out[i] = 1.0f;
+        return;
+    }
+
+    const float g0 = p->glide - 1.0f;
+    const float e0 = p->sweep;
+
+    for (int i = 0; i < frames; i++) {
+        float e = e0 - (float)(i + 1) * s->sweep_step;
+        if (e < 0.0f) e = 0.0f;
+        out[i] = (1.0f + g0 * s->glide->pow[i]) * (1.0f + e * s->sweep_depth);
+    }
+
+    p->glide = 1.0f + g0 * s->glide->pow[frames - 1];
+    p->sweep = e0 - (float)frames * s->sweep_step;
+    if (p->sweep < 0.0f) p->sweep = 0.0f;
+
+    if (p->sweep == 0.0f && fabsf(p->glide - 1.0f) < s->settle) {
+        p->glide = 1.0f;
+        p->steady = 1;
+    }
+}
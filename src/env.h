@@ -0,0 +1,74 @@
+#pragma once
+
+/* =========================
+   BLOCK ENVELOPES
+   The per-sample recurrences of the voice (one-pole amp and glide, a
+   linear pitch sweep) are evaluated in closed form a block at a time:
+
+     x += (t - x) * k   for n frames   =  t + (x0 - t) * (1 - k)^n
+     x -= step          for n frames   =  x0 - n * step
+
+   (1 - k)^n comes from a table per rate, so filling a block is a
+   multiply-add per frame with no dependency between frames. Segment
+   ends are solved for directly, and an envelope that has settled
+   reports itself steady so the caller can skip it entirely.
+========================= */
+#define ENV_MAX_BLOCK 256
+
+typedef struct {
+    float k;
+    float log_c;                /* ln(1 - k) */
+    float pow[ENV_MAX_BLOCK];   /* (1 - k)^(i + 1) */
+} EnvRate;
+
+void env_rate_init(EnvRate *r, float k);
+
+/* =========================
+   ADSR
+========================= */
+enum { ENV_ATTACK, ENV_DECAY, ENV_SUSTAIN, ENV_RELEASE, ENV_IDLE };
+
+typedef struct {
+    const EnvRate *attack;
+    const EnvRate *decay;
+    float peak;
+    float sustain;
+    float settle;   /* attack / decay end within this of their target */
+    float floor;    /* release ends below this */
+} AdsrShape;
+
+typedef struct {
+    int stage;
+    float x;
+    const EnvRate *release;
+} Adsr;
+
+void adsr_start(Adsr *e);
+void adsr_release(Adsr *e, const EnvRate *rate);
+
+/* writes up to frames values; returns how many were written before the
+   envelope went idle (the last of them is the one that crossed floor) */
+int adsr_block(Adsr *e, const AdsrShape *s, float *out, int frames);
+
+/* =========================
+   PITCH
+   Glide (ratio to the target, one-pole toward 1) times a linear sweep
+   of up to depth octaves-worth of multiplier, decaying to 0.
+========================= */
+typedef struct {
+    const EnvRate *glide;
+    float sweep_step;
+    float sweep_depth;
+    float settle;
+} PitchShape;
+
+typedef struct {
+    float glide;
+    float sweep;
+    int steady;
+} PitchEnv;
+
+void pitch_env_start(PitchEnv *p, float glide, float sweep);
+
+/* writes the frequency multiplier for each frame */
+void pitch_env_block(PitchEnv *p, const PitchShape *s, float *out, int frames);
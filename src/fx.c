@@ -0,0 +1,117 @@
+#include "fx.h"
+#include "reverb.h"
+#include <math.h>
+#include <string.h>
+
+#define TWO_PI 6.28318531f
+
+/* =========================
+   CHAIN
+========================= */
+void fx_chain_init(FxChain *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+int fx_chain_add(FxChain *c, const char *name, FxProcess fn, void *state) {
+    if (c->count >= FX_MAX_NODES)
+        return -1;
+
+    int id = c->count;
+    FxNode *n = &c->nodes[id];
+    n->name = name;
+    n->process = fn;
+    n->state = state;
+    n->bypass = 0;
+
+    c->order[id] = id;
+    c->count++;
+    return id;
+}
+
+void fx_chain_move(FxChain *c, int from, int to) {
+    if (from < 0 || from >= c->count || to < 0 || to >= c->count)
+        return;
+
+    int id = c->order[from];
+    if (from < to)
+        memmove(&c->order[from], &c->order[from + 1], (to - from) * sizeof(int));
+    else
+        memmove(&c->order[to + 1], &c->order[to], (from - to) * sizeof(int));
+    c->order[to] = id;
+}
+
+void fx_chain_process(FxChain *c, float *L, float *R, int frames) {
+    for (int i = 0; i < c->count; i++) {
+        FxNode *n = &c->nodes[c->order[i]];
+        if (!n->bypass)
+            n->process(n->state, L, R, frames);
+    }
+}
+
+/* =========================
+   TREMOLO
+========================= */
+void tremolo_init(Tremolo *t, int sample_rate, float rate, float depth) {
+    t->phase = 0.0f;
+    t->inc = TWO_PI * rate / sample_rate;
+    t->depth = depth;
+}
+
+void fx_tremolo(void *state, float *L, float *R, int frames) {
+    Tremolo *t = state;
+
+    for (int i = 0; i < frames; i++) {
+        t->phase += t->inc;
+        if (t->phase > TWO_PI)
+            t->phase -= TWO_PI;
+        float g = (1.0f - t->depth) + t->depth * (0.5f + 0.5f * sinf(t->phase));
+        L[i] *= g;
+        R[i] *= g;
+    }
+}
+
+/* =========================
+   CHORUS
+========================= */
+void chorus_init(Chorus *c, int sample_rate, float rate, float delay_s, float depth_s) {
+    memset(c->bufL, 0, sizeof(c->bufL));
+    memset(c->bufR, 0, sizeof(c->bufR));
+    c->idx = 0;
+    c->phase = 0.0f;
+    c->inc = TWO_PI * rate / sample_rate;
+    c->delay = delay_s * sample_rate;
+    c->depth = depth_s * sample_rate;
+}
+
+void fx_chorus(void *state, float *L, float *R, int frames) {
+    Chorus *c = state;
+
+    for (int i = 0; i < frames; i++) {
+        c->phase += c->inc;
+        if (c->phase > TWO_PI)
+            c->phase -= TWO_PI;
+
+        int d = (int)(c->delay + sinf(c->phase) * c->depth);
+        if (d < 1) d = 1;
+        if (d > CHORUS_MASK) d = CHORUS_MASK;
+
+        int read = (c->idx - d) & CHORUS_MASK;
+        float dl = c->bufL[read];
+        float dr = c->bufR[read];
+
+        c->bufL[c->idx] = L[i];
+        c->bufR[c->idx] = R[i];
+
+        L[i] = L[i] * 0.7f + dl * 0.3f;
+        R[i] = R[i] * 0.7f + dr * 0.3f;
+
+        c->idx = (c->idx + 1) & CHORUS_MASK;
+    }
+}
+
+/* =========================
+   REVERB
+========================= */
+void fx_reverb(void *state, float *L, float *R, int frames) {
+    reverb_process(state, L, R, frames);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+/* =========================
+   EFFECTS CHAIN
+   Each node processes a stereo block in place. Nodes are registered
+   once at startup; reordering and bypass only touch the order table
+   and flags, so the audio thread never allocates.
+========================= */
+#define FX_MAX_NODES 8
+#define FX_ALIGN     __attribute__((aligned(32)))
+
+typedef void (*FxProcess)(void *state, float *L, float *R, int frames);
+
+typedef struct {
+    const char *name;
+    FxProcess process;
+    void *state;
+    int bypass;
+} FxNode;
+
+typedef struct {
+    FxNode nodes[FX_MAX_NODES];
+    int order[FX_MAX_NODES];    /* processing order, as node ids */
+    int count;
+} FxChain;
+
+void fx_chain_init(FxChain *c);
+int  fx_chain_add(FxChain *c, const char *name, FxProcess fn, void *state);
+void fx_chain_move(FxChain *c, int from, int to);
+void fx_chain_process(FxChain *c, float *L, float *R, int frames);
+
+/* =========================
+   BUILT-IN NODES
+========================= */
+typedef struct {
+    float phase;
+    float inc;
+    float depth;
+} Tremolo;
+
+#define CHORUS_BUF_LEN 4096            /* power of two */
+#define CHORUS_MASK    (CHORUS_BUF_LEN - 1)
+
+typedef struct {
+    float bufL[CHORUS_BUF_LEN];
+    float bufR[CHORUS_BUF_LEN];
+    int   idx;
+
+    float phase;
+    float inc;
+    float delay;                /* centre delay, in samples */
+    float depth;                /* modulation depth, in samples */
+} Chorus;
+
+void tremolo_init(Tremolo *t, int sample_rate, float rate, float depth);
+void chorus_init(Chorus *c, int sample_rate, float rate, float delay_s, float depth_s);
+
+void fx_tremolo(void *state, float *L, float *R, int frames);
+void fx_chorus(void *state, float *L, float *R, int frames);
+void fx_reverb(void *state, float *L, float *R, int frames);
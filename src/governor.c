@@ -0,0 +1,62 @@
+#include "governor.h"
+
+void governor_init(Governor *g) {
+    g->load = 0.0f;
+    g->tier = GOV_FULL;
+    g->over = 0;
+    g->under = 0;
+    g->up_wait = GOV_UP_COUNT;
+    g->since_up = GOV_UP_MAX;
+}
+
+int governor_update(Governor *g, double render_s, double deadline_s) {
+    float load = (deadline_s > 0.0) ? (float)(render_s / deadline_s) : 0.0f;
+
+    /* spikes register at once, then fade */
+    g->load *= GOV_LOAD_DECAY;
+    if (load > g->load)
+        g->load = load;
+
+    if (g->since_up < GOV_UP_MAX)
+        g->since_up++;
+
+    if (load > GOV_HIGH) {
+        g->under = 0;
+        if (++g->over >= GOV_DOWN_COUNT && g->tier < GOV_TIERS - 1) {
+            /* the last step up did not hold: wait longer next time */
+            if (g->since_up < g->up_wait && g->up_wait < GOV_UP_MAX)
+                g->up_wait *= 2;
+            g->tier++;
+            g->over = 0;
+        }
+    }
+    else if (g->load < GOV_LOW) {
+        g->over = 0;
+        if (++g->under >= g->up_wait && g->tier > GOV_FULL) {
+            g->tier--;
+            g->under = 0;
+            g->since_up = 0;
+        }
+    }
+    else {
+        g->over = 0;
+        g->under = 0;
+    }
+
+    /* a long calm stretch forgets earlier back-offs */
+    if (g->tier == GOV_FULL && g->since_up >= GOV_UP_MAX)
+        g->up_wait = GOV_UP_COUNT;
+
+    return g->tier;
+}
+
+const char *governor_tier_name(int tier) {
+    switch (tier) {
+        case GOV_FULL:   return "FULL";
+        case GOV_UNISON: return "UNISON";
+        case GOV_LFO:    return "LFO";
+        case GOV_FX:     return "FX";
+        case GOV_STEAL:  return "STEAL";
+        default:         return "";
+    }
+}
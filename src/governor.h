@@ -0,0 +1,41 @@
+#pragma once
+
+/* =========================
+   CPU GOVERNOR
+   Compares the time spent rendering each callback with the time that
+   callback's audio lasts. Sustained load above GOV_HIGH steps quality
+   down one tier; it only steps back up after load has stayed below
+   GOV_LOW for much longer. A step up that is undone right away doubles
+   the wait before the next try, so the tiers do not flap.
+========================= */
+enum {
+    GOV_FULL,       /* everything on */
+    GOV_UNISON,     /* unison stack capped */
+    GOV_LFO,        /* LFOs evaluated at control rate */
+    GOV_FX,         /* effects reduced */
+    GOV_STEAL,      /* quietest voices are stolen while over budget */
+    GOV_TIERS
+};
+
+#define GOV_HIGH        0.70f   /* fraction of the deadline */
+#define GOV_LOW         0.40f
+#define GOV_DOWN_COUNT  4       /* callbacks over GOV_HIGH before stepping down */
+#define GOV_UP_COUNT    400     /* callbacks under GOV_LOW before stepping up */
+#define GOV_UP_MAX      (GOV_UP_COUNT * 16)
+#define GOV_LOAD_DECAY  0.95f   /* peak-hold release per callback */
+
+typedef struct {
+    float load;     /* peak-held render time / deadline */
+    int tier;
+    int over;
+    int under;
+    int up_wait;    /* current GOV_UP_COUNT, backed off after failed steps */
+    int since_up;   /* callbacks since the last step up */
+} Governor;
+
+void governor_init(Governor *g);
+
+/* feeds one callback's timing; returns the tier to run the next one at */
+int governor_update(Governor *g, double render_s, double deadline_s);
+
+const char *governor_tier_name(int tier);
@@ -3,13 +3,23 @@
 #include <SDL.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "ahead.h"
+#include "env.h"
+#include "fx.h"
+#include "governor.h"
+#include "recorder.h"
+#include "reverb.h"
+#include "rt.h"
 
 /* =========================
    CONFIG
 ========================= */
 #define SAMPLE_RATE 44100
-#define MAX_VOICES  16
+#define MAX_VOICES  1024
 #define NUM_NOTES   8
 
 #define WINDOW_W 900
@@ -28,13 +38,49 @@
 #define CHORUS_DEPTH 0.0025f
 #define CHORUS_DELAY 0.025f
 
-/* Jetsons envelopes */
+/* reverb */
+#define REVERB_DECAY 2.2f      /* seconds to -60 dB */
+#define REVERB_DAMP  0.35f
+#define REVERB_MIX   0.35f
+
+/* frames rendered per pass through the effects chain */
+#define BLOCK_SIZE 256
+
+/* Jetsons envelopes (one-pole rates per sample) */
+#define AMP_LEVEL    0.35f     /* attack peak */
+#define AMP_SUSTAIN  0.35f
 #define AMP_ATTACK   0.004f
+#define AMP_DECAY    0.001f
 #define AMP_RELEASE  0.002f
+#define AMP_SETTLE   0.00001f  /* attack / decay considered done */
+#define AMP_FLOOR    0.0005f   /* release ends, voice is freed */
 
 #define PITCH_DECAY  0.0018f
 #define PITCH_SWEEP  2.0f      /* up to +2 octaves */
 #define GLIDE_RATE   0.0025f
+#define GLIDE_SETTLE 0.00001f  /* glide ratio considered done */
+
+#if BLOCK_SIZE > ENV_MAX_BLOCK
+#error "BLOCK_SIZE exceeds the envelope power tables"
+#endif
+
+/* unison: oscillators per voice */
+#define MAX_UNISON     16
+#define UNISON_DEFAULT 6
+#define UNISON_DETUNE  5.0f    /* cents, outermost oscillators */
+#define UNISON_WIDTH   0.75f   /* stereo spread, 0 = mono */
+
+/* governor tiers: what each one gives up */
+#define GOV_UNISON_CAP 3       /* oscillators per voice */
+#define GOV_LFO_STEP   32      /* frames between LFO evaluations */
+
+/* attack cache: frames of glide / sweep / amp rise read from tables */
+#define ATTACK_LEN   4096
+
+/* render-ahead (--render-ahead N): frames per render-thread block and
+   the deepest lead allowed */
+#define AHEAD_BLOCK      1024
+#define AHEAD_MAX_BLOCKS (AHEAD_RING_FRAMES / AHEAD_BLOCK)
 
 /* =========================
    JETSONS ENGINE FLUTTER
@@ -48,43 +94,162 @@ static float engine_phase = 0.0f;
 
 /* =========================
    VOICE STRUCT
+   Hot state is touched every sample and is cache-line aligned, so no
+   two voices share a line: the unison phases fill the first line and
+   the pitch / amp state sits in the second. Cold state is only read on
+   note events.
 ========================= */
-typedef struct {
-    float phase[6];
+#define CACHE_LINE 64
+
+typedef struct __attribute__((aligned(CACHE_LINE))) {
+    float phase[MAX_UNISON];   /* 0..1, one per unison oscillator */
 
-    float base_freq;
-    float current_freq;
     float target_freq;
+    PitchEnv pitch;    /* glide and +2 octave sweep */
+    Adsr env;
 
-    float amp;
-    float amp_target;
-    int sustaining;
-    float pitch_env;   /* 1.0 → 0.0 */
-    float vib_offset;
+    int attack_pos;    /* frame into the attack cache, -1 when live */
+} VoiceHot;
 
-    int active;
-} Voice;
+typedef struct {
+    float base_freq;
+    float vib_offset;
+    int sustaining;
+    Uint32 serial;     /* note-on order, for stealing the oldest */
+    int key, key_gen;  /* UI key and press that started it, key -1 if none */
+} VoiceCold;
 
 /* =========================
    GLOBAL STATE
 ========================= */
-static Voice voices[MAX_VOICES];
+static VoiceHot  voice_hot[MAX_VOICES];
+static VoiceCold voice_cold[MAX_VOICES];
+
+/* sounding voices, dense; compacted after every block */
+static int active_list[MAX_VOICES];
+static int num_active = 0;
+
+/* idle voice slots, used as a stack */
+static int free_list[MAX_VOICES];
+static int num_free = 0;
+
 static int running = 1;
 
 /* LFOs */
 static float vibrato_phase = 0.0f;
-static float tremolo_phase = 0.0f;
-static float chorus_phase  = 0.0f;
+static int   lfo_step = 1;              /* frames between evaluations */
+static int   lfo_tick = 0;
+static float lfo_vib_hold, lfo_engine_hold;
+
+/* load governor, updated at the end of every callback */
+static Governor governor;
 
-/* effect toggles */
-static int tremolo_on = 1;
-static int chorus_on  = 1;
+/* real-time mode (--rt): each engine thread sets itself up on its
+   first run and leaves the results for the UI thread to log */
+typedef struct {
+    const char *name;
+    SDL_atomic_t state;         /* 0 pending, 1 ready to log, 2 logged */
+    char prio[96];
+    char ftz[96];
+} RtThread;
+
+static int rt_mode = 0;
+static RtThread rt_audio  = { "audio" };
+static RtThread rt_render = { "render" };
+
+/* engine events: the UI never touches engine state directly */
+enum {
+    EV_NOTE_ON,     /* f = frequency, a = key, b = press count of that key */
+    EV_NOTE_OFF,    /* f = frequency */
+    EV_ALL_OFF,
+    EV_BYPASS,      /* a = fx node id */
+    EV_FX_MOVE,     /* a = from, b = to */
+    EV_UNISON,      /* a = oscillators per voice */
+    EV_STOLEN       /* engine -> UI: a = key, b = press count */
+};
+
+static EventQueue events;
+static EventQueue notices;          /* the other way, drained by the UI */
+static Uint32 engine_frame;         /* next frame the engine renders */
+
+/* device clock: engine frames handed to SDL so far (silence filled in
+   for an underrun does not count), and when the last buffer went */
+static SDL_atomic_t play_frame;
+static SDL_atomic_t play_ticks;
+static int device_frames;
+
+/* render-ahead: 0 renders inside the callback */
+static int ahead_blocks = 0;
+static int ahead_frames;
+static FrameRing ahead_ring;
+static int16_t ahead_block[AHEAD_BLOCK * 2];
+static SDL_Thread *render_thread;
+static SDL_sem *render_wake;
+static SDL_atomic_t render_run;
+static SDL_atomic_t ahead_underruns;
+
+/* effects chain, in default signal order */
+static FxChain fx;
+static Tremolo tremolo;
+static Chorus  chorus;
+static Reverb  reverb;
+static int fx_tremolo_id, fx_chorus_id, fx_reverb_id;
+
+/* pre-rendered attack, identical for every note relative to its pitch */
+static int attack_cache_on = 1;
+static float attack_freq[ATTACK_LEN];   /* glide * pitch sweep */
+static float attack_glide[ATTACK_LEN];  /* current_freq / target_freq */
+static float attack_env[ATTACK_LEN];    /* pitch_env */
+static float attack_amp[ATTACK_LEN];
+
+/* session capture, fed each finished block by the engine (audio_cb, or
+   the render thread with --render-ahead) */
+static Recorder recorder;
+
+/* envelope rates and shapes */
+static EnvRate rate_attack, rate_decay, rate_release, rate_glide;
+static AdsrShape amp_shape;
+static PitchShape pitch_shape;
+
+/* per-frame LFO values, shared by every voice in a block:
+   frequency multiplier, amp flutter, and the running sum of the
+   multiplier in cycles per Hz (a steady voice's phase offset) */
+static float lfo_fmul[BLOCK_SIZE] FX_ALIGN;
+static float lfo_gain[BLOCK_SIZE] FX_ALIGN;
+static float lfo_cum[BLOCK_SIZE] FX_ALIGN;
+static float lfo_cum_end;
+
+/* per-voice scratch */
+static float voice_fmul[BLOCK_SIZE] FX_ALIGN;
+static float voice_amp[BLOCK_SIZE] FX_ALIGN;
+static float voice_cum[BLOCK_SIZE] FX_ALIGN;
+static float voice_gain[BLOCK_SIZE] FX_ALIGN;
+
+/* unison patch and the per-oscillator tables derived from it */
+typedef struct {
+    int   unison;           /* 1 .. MAX_UNISON */
+    float detune_cents;
+    float width;
+} Patch;
+
+static Patch patch = { UNISON_DEFAULT, UNISON_DETUNE, UNISON_WIDTH };
+static Patch engine_patch;          /* the engine's copy, updated by EV_UNISON */
+
+typedef struct {
+    int   count;
+    int   square[MAX_UNISON];   /* square, else triangle */
+    float ratio[MAX_UNISON];
+    float gainL[MAX_UNISON];
+    float gainR[MAX_UNISON];
+} UnisonTable;
 
-/* delay buffer for chorus */
-#define DELAY_BUF_SIZE (SAMPLE_RATE / 2)
-static float delayL[DELAY_BUF_SIZE];
-static float delayR[DELAY_BUF_SIZE];
-static int delay_idx = 0;
+static UnisonTable uni_full;            /* the patch as set */
+static UnisonTable uni_capped;          /* at most GOV_UNISON_CAP, for the UNISON tier */
+static const UnisonTable *uni = &uni_full;
+
+/* voice mix, processed in place by the chain */
+static float blockL[BLOCK_SIZE] FX_ALIGN;
+static float blockR[BLOCK_SIZE] FX_ALIGN;
 
 /* diatonic C major scale */
 static float note_freqs[NUM_NOTES] = {
@@ -94,199 +259,610 @@ static float note_freqs[NUM_NOTES] = {
 static const char *note_names[NUM_NOTES] = {"C","D","E","F","G","A","B","C"};
 
 static int note_active[NUM_NOTES] = {0};
+static int note_gen[NUM_NOTES] = {0};      /* presses per key, matches EV_STOLEN to a press */
+
+/* =========================
+   UNISON
+   Oscillators alternate square / triangle and are spread evenly in
+   detune. Pan positions interleave from the outside in, so neighbours
+   in pitch land on opposite sides. Gains are equal-power and scale with
+   1/sqrt(n) so loudness holds as the stack grows; the default stack
+   keeps the old per-oscillator level. The governor's capped table is
+   laid out the same way, so it stays centred in pitch and pan.
+========================= */
+static void unison_build(UnisonTable *u, int n, const Patch *p)
+{
+    float level = (float)M_SQRT1_2 / sqrtf((float)UNISON_DEFAULT * n);
+
+    for (int o = 0; o < n; o++) {
+        float spread = (n > 1) ? 2.0f * o / (n - 1) - 1.0f : 0.0f;
+
+        int slot = (o & 1) ? n - 1 - o / 2 : o / 2;
+        float pan = (n > 1) ? (2.0f * slot / (n - 1) - 1.0f) * p->width : 0.0f;
+        float theta = (pan + 1.0f) * (float)M_PI * 0.25f;
 
-/* per-oscillator pan (-1 left .. +1 right) */
-static const float osc_pan[6] = {-0.7f,-0.3f,0.0f,0.2f,0.5f,0.8f};
+        u->square[o] = !(o & 1);
+        u->ratio[o] = powf(2.0f, spread * p->detune_cents / 1200.0f);
+        u->gainL[o] = cosf(theta) * level;
+        u->gainR[o] = sinf(theta) * level;
+    }
+    u->count = n;
+}
+
+static void patch_apply(const Patch *p)
+{
+    int n = p->unison;
+    if (n < 1) n = 1;
+    if (n > MAX_UNISON) n = MAX_UNISON;
+
+    unison_build(&uni_full, n, p);
+    unison_build(&uni_capped, (n < GOV_UNISON_CAP) ? n : GOV_UNISON_CAP, p);
+}
 
 /* =========================
-   OSCILLATORS
+   ATTACK CACHE
+   Glide from half pitch, the +2 octave sweep and the amp rise are the
+   same curves for every note, so they are stepped once at startup and
+   voices read them until the cache runs out or the note is released.
+   Oscillators stay live: the engine flutter is a pitch modulation, so
+   attack audio cannot be pre-rendered without losing it. make bench
+   shows what the cache saves.
 ========================= */
-static float square(float p) {
-    return (fmodf(p, 1.0f) < 0.5f) ? 1.0f : -1.0f;
+static void envelopes_init(void) {
+    env_rate_init(&rate_attack, AMP_ATTACK);
+    env_rate_init(&rate_decay, AMP_DECAY);
+    env_rate_init(&rate_release, AMP_RELEASE);
+    env_rate_init(&rate_glide, GLIDE_RATE);
+
+    amp_shape.attack = &rate_attack;
+    amp_shape.decay = &rate_decay;
+    amp_shape.peak = AMP_LEVEL;
+    amp_shape.sustain = AMP_SUSTAIN;
+    amp_shape.settle = AMP_SETTLE;
+    amp_shape.floor = AMP_FLOOR;
+
+    pitch_shape.glide = &rate_glide;
+    pitch_shape.sweep_step = PITCH_DECAY;
+    pitch_shape.sweep_depth = PITCH_SWEEP;
+    pitch_shape.settle = GLIDE_SETTLE;
 }
-static float triangle(float p) {
-    float x = fmodf(p, 1.0f);
-    return 4.0f * fabsf(x - 0.5f) - 1.0f;
+
+static void attack_cache_init(void) {
+    float glide = 0.5f;
+    float env = 1.0f;
+    float amp = 0.0f;
+
+    for (int i = 0; i < ATTACK_LEN; i++) {
+        env -= PITCH_DECAY;
+        if (env < 0.0f) env = 0.0f;
+        glide += (1.0f - glide) * GLIDE_RATE;
+        amp += (AMP_LEVEL - amp) * AMP_ATTACK;
+
+        attack_glide[i] = glide;
+        attack_env[i] = env;
+        attack_freq[i] = glide * (1.0f + env * PITCH_SWEEP);
+        attack_amp[i] = amp;
+    }
+}
+
+/* hands a cached voice over to the live envelopes at its current frame */
+static void attack_leave(VoiceHot *v) {
+    int k = v->attack_pos - 1;
+    if (k >= 0) {
+        pitch_env_start(&v->pitch, attack_glide[k], attack_env[k]);
+        v->env.x = attack_amp[k];
+    }
+    v->attack_pos = -1;
 }
 
 /* =========================
    VOICE CONTROL
+   Called from the UI thread with the audio device locked.
 ========================= */
-static void note_on(float freq) {
-    for (int i = 0; i < MAX_VOICES; i++) {
-        if (!voices[i].active) {
-            Voice *v = &voices[i];
-            memset(v->phase, 0, sizeof(v->phase));
-
-            v->base_freq   = freq;
-            v->current_freq = freq * 0.5f;   /* start low */
-            v->target_freq  = freq;
-
-            v->amp = 0.0f;
-            v->amp_target = 0.35f;
-            v->sustaining = 1;
-            v->pitch_env = 1.0f;  /* start with sweep */
-
-            v->vib_offset = (float)i * 1.31f;
-            v->active = 1;
-            break;
-        }
-    }
+static void voices_init(void) {
+    num_active = 0;
+    num_free = 0;
+    for (int i = MAX_VOICES - 1; i >= 0; i--)
+        free_list[num_free++] = i;
+}
+
+static Uint32 note_serial;
+
+static void note_on(float freq, int key, int key_gen) {
+    if (num_free == 0)
+        return;
+
+    int i = free_list[--num_free];
+    VoiceHot  *v = &voice_hot[i];
+    VoiceCold *c = &voice_cold[i];
+
+    memset(v->phase, 0, sizeof(v->phase));
+    v->target_freq = freq;
+    pitch_env_start(&v->pitch, 0.5f, 1.0f);   /* start low, with sweep */
+    adsr_start(&v->env);
+    v->attack_pos = attack_cache_on ? 0 : -1;
+
+    c->base_freq = freq;
+    c->vib_offset = (float)i * 1.31f;
+    c->sustaining = 1;
+    c->serial = note_serial++;
+    c->key = key;
+    c->key_gen = key_gen;
+
+    active_list[num_active++] = i;
 }
 
 static void note_off(float freq)
 {
-    for (int i = 0; i < MAX_VOICES; i++) {
-        if (voices[i].active &&
-            fabsf(voices[i].base_freq - freq) < 0.1f) {
-            voices[i].sustaining = 0;
-            voices[i].amp_target = 0.0f;
+    for (int a = 0; a < num_active; a++) {
+        int i = active_list[a];
+        if (fabsf(voice_cold[i].base_freq - freq) < 0.1f) {
+            if (voice_hot[i].attack_pos >= 0)
+                attack_leave(&voice_hot[i]);
+            voice_cold[i].sustaining = 0;
+            adsr_release(&voice_hot[i].env, &rate_release);
         }
     }
 }
 
 
+/* quick fade at the attack rate; voices already releasing keep their tail */
 static void all_notes_off(void) {
-    for (int i = 0; i < MAX_VOICES; i++)
-        voices[i].amp_target = 0.0f;
+    for (int a = 0; a < num_active; a++) {
+        VoiceHot *v = &voice_hot[active_list[a]];
+        if (v->attack_pos >= 0)
+            attack_leave(v);
+        if (v->env.stage != ENV_RELEASE)
+            adsr_release(&v->env, &rate_attack);
+    }
 }
 
 /* =========================
    AUDIO CALLBACK
 ========================= */
-void audio_cb(void *ud, Uint8 *stream, int len)
+static void render_lfos(int frames)
 {
-    int16_t *out = (int16_t*)stream;
-    int frames = len / (sizeof(int16_t) * 2);
+    float cum = 0.0f;
 
     for (int i = 0; i < frames; i++) {
-        float mixL = 0.0f;
-        float mixR = 0.0f;
-
         /* vibrato */
         vibrato_phase += (2.0f * (float)M_PI * VIB_RATE) / SAMPLE_RATE;
         if (vibrato_phase > 2.0f * (float)M_PI)
             vibrato_phase -= 2.0f * (float)M_PI;
-        float vib = sinf(vibrato_phase);
 
         /* engine flutter LFO (FAST, mechanical) */
         engine_phase += (2.0f * (float)M_PI * ENGINE_RATE) / SAMPLE_RATE;
         if (engine_phase > 2.0f * (float)M_PI)
             engine_phase -= 2.0f * (float)M_PI;
 
-        /* square-like flutter */
-        float engine = sinf(engine_phase);
-        engine = (engine > 0.0f) ? 1.0f : -1.0f;
+        /* evaluated every frame, or held for lfo_step frames under load */
+        if (lfo_tick == 0) {
+            lfo_vib_hold = sinf(vibrato_phase);
 
+            /* square-like flutter */
+            lfo_engine_hold = (sinf(engine_phase) > 0.0f) ? 1.0f : -1.0f;
+        }
+        if (++lfo_tick >= lfo_step)
+            lfo_tick = 0;
 
-        for (int v = 0; v < MAX_VOICES; v++) {
-            Voice *vc = &voices[v];
-            if (!vc->active) continue;
+        float vib = lfo_vib_hold;
+        float engine = lfo_engine_hold;
 
-            /* pitch envelope decay */
-            vc->pitch_env -= PITCH_DECAY;
-            if (vc->pitch_env < 0.0f) vc->pitch_env = 0.0f;
+        /* subtle slow vibrato, FAST Jetsons engine flutter */
+        lfo_fmul[i] = (1.0f + vib * 0.001f) * (1.0f + engine * ENGINE_DEPTH);
 
-            float pitch_mul = 1.0f + vc->pitch_env * PITCH_SWEEP;
+        /* engine amplitude flutter */
+        lfo_gain[i] = 1.0f - ENGINE_AM + ENGINE_AM * fabsf(engine);
 
-            /* glide */
-            vc->current_freq += (vc->target_freq - vc->current_freq) * GLIDE_RATE;
+        lfo_cum[i] = cum;
+        cum += lfo_fmul[i] / SAMPLE_RATE;
+    }
+    lfo_cum_end = cum;
+}
 
-            float f = vc->current_freq * pitch_mul;
+/* oscillators: each phase is its start phase plus its ratio times the
+   voice's phase offset for the frame, so frames are independent */
+static void render_oscillators(VoiceHot *vc, float *restrict L, float *restrict R,
+                               const float *restrict cum, float cum_scale, float cum_end,
+                               const float *restrict gain, float gain_scale, int frames)
+{
+    const UnisonTable *u = uni;
+
+    for (int o = 0; o < u->count; o++) {
+        const float p0 = vc->phase[o];
+        const float r  = u->ratio[o] * cum_scale;
+        const float gl = u->gainL[o] * gain_scale;
+        const float gr = u->gainR[o] * gain_scale;
+
+        if (u->square[o]) {
+            for (int i = 0; i < frames; i++) {
+                float p = p0 + r * cum[i];
+                p -= (float)(int)p;
+                float s = ((p < 0.5f) ? 1.0f : -1.0f) * gain[i];
+                L[i] += s * gl;
+                R[i] += s * gr;
+            }
+        }
+        else {
+            for (int i = 0; i < frames; i++) {
+                float p = p0 + r * cum[i];
+                p -= (float)(int)p;
+                float s = (4.0f * fabsf(p - 0.5f) - 1.0f) * gain[i];
+                L[i] += s * gl;
+                R[i] += s * gr;
+            }
+        }
 
-            /* subtle slow vibrato */
-            f *= (1.0f + vib * 0.001f);
+        float p = p0 + r * cum_end;
+        vc->phase[o] = p - (float)(int)p;
+    }
+}
 
-            /* FAST Jetsons engine flutter */
-            f *= (1.0f + engine * ENGINE_DEPTH);
+/* renders one voice into the mix; returns 0 once it has died out */
+static int render_voice(VoiceHot *vc, float *L, float *R, int frames)
+{
+    /* settled voice: no envelope work at all, the shared LFO tables
+       scaled by its pitch and level drive the oscillators directly */
+    if (vc->attack_pos < 0 && vc->env.stage == ENV_SUSTAIN && vc->pitch.steady) {
+        render_oscillators(vc, L, R, lfo_cum, vc->target_freq, lfo_cum_end,
+                           lfo_gain, vc->env.x, frames);
+        return 1;
+    }
 
+    float *fmul = voice_fmul;
+    float *amp = voice_amp;
+    int n = 0;
+
+    /* attack: stream envelopes from the cache */
+    if (vc->attack_pos >= 0) {
+        n = ATTACK_LEN - vc->attack_pos;
+        if (n > frames) n = frames;
+        memcpy(fmul, &attack_freq[vc->attack_pos], n * sizeof(float));
+        memcpy(amp, &attack_amp[vc->attack_pos], n * sizeof(float));
+        vc->attack_pos += n;
+        if (vc->attack_pos == ATTACK_LEN)
+            attack_leave(vc);
+    }
 
-            float voiceL = 0.0f;
-            float voiceR = 0.0f;
+    /* live envelopes, a block at a time */
+    int alive = 1;
+    if (n < frames) {
+        pitch_env_block(&vc->pitch, &pitch_shape, fmul + n, frames - n);
+        int sounding = adsr_block(&vc->env, &amp_shape, amp + n, frames - n);
+        if (vc->env.stage == ENV_IDLE) {
+            frames = n + sounding;
+            alive = 0;
+        }
+    }
 
-            float osc[6];
-            osc[0] = square(vc->phase[0]);
-            osc[1] = square(vc->phase[1] * 1.002f);
-            osc[2] = square(vc->phase[2] * 0.998f);
-            osc[3] = triangle(vc->phase[3]);
-            osc[4] = triangle(vc->phase[4] * 1.003f);
-            osc[5] = triangle(vc->phase[5] * 0.997f);
+    /* phase offset per frame, the only serial step left */
+    const float f = vc->target_freq / SAMPLE_RATE;
+    float ph = 0.0f;
+    for (int i = 0; i < frames; i++) {
+        voice_cum[i] = ph;
+        ph += f * fmul[i] * lfo_fmul[i];
+    }
 
-            for (int o = 0; o < 6; o++) {
-                float p = osc_pan[o];
-                voiceL += osc[o] * (1.0f - p) * 0.5f;
-                voiceR += osc[o] * (1.0f + p) * 0.5f;
-                vc->phase[o] += f / SAMPLE_RATE;
-            }
+    for (int i = 0; i < frames; i++)
+        voice_gain[i] = amp[i] * lfo_gain[i];
 
-            voiceL *= (1.0f / 6.0f);
-            voiceR *= (1.0f / 6.0f);
+    render_oscillators(vc, L, R, voice_cum, 1.0f, ph, voice_gain, 1.0f, frames);
+    return alive;
+}
 
-            if (vc->sustaining) {
-                /* attack / sustain */
-                vc->amp += (vc->amp_target - vc->amp) * AMP_ATTACK;
-            }
-            else {
-                /* release */
-                vc->amp += (0.0f - vc->amp) * AMP_RELEASE;
-            }
+static void render_block(float *L, float *R, int frames)
+{
+    memset(L, 0, frames * sizeof(float));
+    memset(R, 0, frames * sizeof(float));
+
+    render_lfos(frames);
+
+    /* only sounding voices are visited; finished ones go back to the pool */
+    int kept = 0;
+    for (int a = 0; a < num_active; a++) {
+        int v = active_list[a];
+        if (render_voice(&voice_hot[v], L, R, frames))
+            active_list[kept++] = v;
+        else
+            free_list[num_free++] = v;
+    }
+    num_active = kept;
+}
 
+/* current amp level; voices still in the attack cache are read from it
+   without being handed back to the live envelope */
+static float voice_level(const VoiceHot *v)
+{
+    if (v->attack_pos > 0)
+        return attack_amp[v->attack_pos - 1];
+    if (v->attack_pos == 0)
+        return 0.0f;
+    return v->env.x;
+}
 
-/* engine amplitude flutter */
-float amp_flutter = 1.0f - ENGINE_AM + ENGINE_AM * fabsf(engine);
+/* whether voice a goes before voice b. A rising attack is always below
+   the sustain level, so attacking voices are spared while any other is
+   held; otherwise the quietest goes first, then the oldest */
+static int steal_before(int a, int b)
+{
+    int attack_a = (voice_hot[a].env.stage == ENV_ATTACK);
+    int attack_b = (voice_hot[b].env.stage == ENV_ATTACK);
+    if (attack_a != attack_b)
+        return attack_b;
+
+    if (!attack_a) {
+        float level_a = voice_level(&voice_hot[a]);
+        float level_b = voice_level(&voice_hot[b]);
+        if (level_a != level_b)
+            return level_a < level_b;
+    }
+    return (int)(voice_cold[a].serial - voice_cold[b].serial) < 0;
+}
 
-mixL += voiceL * vc->amp * amp_flutter;
-mixR += voiceR * vc->amp * amp_flutter;
+/* one held voice fades out quickly to make room; its key is handed back
+   to the UI so the next press starts a new note */
+static void steal_quietest(void)
+{
+    int quiet = -1;
+
+    for (int a = 0; a < num_active; a++) {
+        int v = active_list[a];
+        if (voice_hot[v].env.stage == ENV_RELEASE)
+            continue;
+        if (quiet < 0 || steal_before(v, quiet))
+            quiet = v;
+    }
+    if (quiet < 0)
+        return;
+
+    VoiceHot *v = &voice_hot[quiet];
+    if (v->attack_pos >= 0)
+        attack_leave(v);
+    adsr_release(&v->env, &rate_attack);
+    voice_cold[quiet].sustaining = 0;
+
+    if (voice_cold[quiet].key >= 0) {
+        Event n = { .type = EV_STOLEN, .a = voice_cold[quiet].key, .b = voice_cold[quiet].key_gen };
+        event_push(&notices, &n);   /* a full queue only leaves a key lit */
+    }
+}
 
+/* sets up the next callback for the governor's tier */
+static void governor_apply(int tier, int over_budget)
+{
+    uni = (tier >= GOV_UNISON) ? &uni_capped : &uni_full;
+    lfo_step  = (tier >= GOV_LFO) ? GOV_LFO_STEP : 1;
+    reverb_set_lite(&reverb, tier >= GOV_FX);
 
-            if (vc->amp < 0.0005f && vc->amp_target == 0.0f)
-                vc->active = 0;
+    if (tier >= GOV_STEAL && over_budget)
+        steal_quietest();
+}
+
+/* one-time real-time setup, run on the thread itself */
+static void rt_thread_init(RtThread *t)
+{
+    rt_promote_thread(t->prio, sizeof(t->prio));
+    rt_enable_ftz(t->ftz, sizeof(t->ftz));
+    rt_prefault_stack(64 * 1024);
+    SDL_AtomicSet(&t->state, 1);
+}
+
+static void rt_thread_log(RtThread *t)
+{
+    if (SDL_AtomicGet(&t->state) != 1)
+        return;
+    printf("rt: %s thread %s\n", t->name, t->prio);
+    printf("rt: %s thread %s\n", t->name, t->ftz);
+    SDL_AtomicSet(&t->state, 2);
+}
+
+/* every buffer the audio thread touches, resident before audio starts */
+static size_t rt_prefault_dsp(void)
+{
+    struct { void *p; size_t n; } bufs[] = {
+        { voice_hot, sizeof(voice_hot) },     { voice_cold, sizeof(voice_cold) },
+        { active_list, sizeof(active_list) }, { free_list, sizeof(free_list) },
+        { attack_freq, sizeof(attack_freq) }, { attack_glide, sizeof(attack_glide) },
+        { attack_env, sizeof(attack_env) },   { attack_amp, sizeof(attack_amp) },
+        { &rate_attack, sizeof(rate_attack) }, { &rate_decay, sizeof(rate_decay) },
+        { &rate_release, sizeof(rate_release) }, { &rate_glide, sizeof(rate_glide) },
+        { lfo_fmul, sizeof(lfo_fmul) },       { lfo_gain, sizeof(lfo_gain) },
+        { lfo_cum, sizeof(lfo_cum) },         { voice_fmul, sizeof(voice_fmul) },
+        { voice_amp, sizeof(voice_amp) },     { voice_cum, sizeof(voice_cum) },
+        { voice_gain, sizeof(voice_gain) },   { blockL, sizeof(blockL) },
+        { blockR, sizeof(blockR) },           { &fx, sizeof(fx) },
+        { &tremolo, sizeof(tremolo) },        { &chorus, sizeof(chorus) },
+        { &reverb, sizeof(reverb) },          { &recorder, sizeof(recorder) },
+        { &events, sizeof(events) },          { &notices, sizeof(notices) },
+        { &ahead_ring, sizeof(ahead_ring) },  { ahead_block, sizeof(ahead_block) },
+    };
+    size_t total = 0;
+    for (size_t i = 0; i < sizeof(bufs) / sizeof(bufs[0]); i++) {
+        rt_prefault(bufs[i].p, bufs[i].n);
+        total += bufs[i].n;
+    }
+    return total;
+}
+
+/* =========================
+   ENGINE
+   Runs in the callback, or on the render thread with --render-ahead.
+   Events apply between chunks; one due inside a chunk cuts it short so
+   it lands on its own frame.
+========================= */
+static void event_apply(const Event *e)
+{
+    switch (e->type) {
+        case EV_NOTE_ON:  note_on(e->f, e->a, e->b); break;
+        case EV_NOTE_OFF: note_off(e->f); break;
+        case EV_ALL_OFF:  all_notes_off(); break;
+        case EV_BYPASS:   fx.nodes[e->a].bypass ^= 1; break;
+        case EV_FX_MOVE:  fx_chain_move(&fx, e->a, e->b); break;
+        case EV_UNISON:
+            engine_patch.unison = e->a;
+            patch_apply(&engine_patch);
+            break;
+    }
+}
+
+static void engine_render(int16_t *out, int frames)
+{
+    while (frames > 0) {
+        int n = (frames < BLOCK_SIZE) ? frames : BLOCK_SIZE;
+
+        const Event *e;
+        while ((e = event_peek(&events))) {
+            int due = (int)(e->frame - engine_frame);
+            if (due > 0) {
+                if (due < n) n = due;
+                break;
+            }
+            event_apply(e);
+            event_pop(&events);
         }
 
-        /* tremolo */
-        if (tremolo_on) {
-            tremolo_phase += (2.0f * (float)M_PI * TREM_RATE) / SAMPLE_RATE;
-            if (tremolo_phase > 2.0f * (float)M_PI)
-                tremolo_phase -= 2.0f * (float)M_PI;
-            float t = (1.0f - TREM_DEPTH) + TREM_DEPTH * (0.5f + 0.5f * sinf(tremolo_phase));
-            mixL *= t;
-            mixR *= t;
+        render_block(blockL, blockR, n);
+        fx_chain_process(&fx, blockL, blockR, n);
+        recorder_push(&recorder, blockL, blockR, n);
+
+        for (int i = 0; i < n; i++) {
+            float mixL = blockL[i];
+            float mixR = blockR[i];
+
+            /* clamp */
+            if (mixL > 1.0f) mixL = 1.0f;
+            if (mixL < -1.0f) mixL = -1.0f;
+            if (mixR > 1.0f) mixR = 1.0f;
+            if (mixR < -1.0f) mixR = -1.0f;
+
+            out[i * 2 + 0] = (int16_t)(mixL * 32767);
+            out[i * 2 + 1] = (int16_t)(mixR * 32767);
         }
 
-        /* chorus */
-        if (chorus_on) {
-            chorus_phase += (2.0f * (float)M_PI * CHORUS_RATE) / SAMPLE_RATE;
-            if (chorus_phase > 2.0f * (float)M_PI)
-                chorus_phase -= 2.0f * (float)M_PI;
+        out += n * 2;
+        frames -= n;
+        engine_frame += n;
+    }
+}
 
-            float mod = sinf(chorus_phase) * CHORUS_DEPTH;
-            int delay_samples = (int)((CHORUS_DELAY + mod) * SAMPLE_RATE);
-            if (delay_samples < 1) delay_samples = 1;
-            if (delay_samples > DELAY_BUF_SIZE - 1) delay_samples = DELAY_BUF_SIZE - 1;
+/* tops the ring up to ahead_frames one AHEAD_BLOCK at a time; the
+   governor budgets each block against the audio still queued */
+static int render_thread_main(void *ud)
+{
+    if (rt_mode)
+        rt_thread_init(&rt_render);
+
+    while (SDL_AtomicGet(&render_run)) {
+        int fill = frame_ring_fill(&ahead_ring);
+        if (fill + AHEAD_BLOCK > ahead_frames) {
+            SDL_SemWaitTimeout(render_wake, 10);
+            continue;
+        }
 
-            int read = (delay_idx - delay_samples + DELAY_BUF_SIZE) % DELAY_BUF_SIZE;
+        /* the block is due when the device has drained what is queued;
+           it takes whole buffers, so only whole ones count */
+        int slack = fill - fill % device_frames;
+        if (slack < device_frames) slack = device_frames;
+        double deadline = (double)slack / SAMPLE_RATE;
 
-            float dl = delayL[read];
-            float dr = delayR[read];
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        engine_render(ahead_block, AHEAD_BLOCK);
+        frame_ring_write(&ahead_ring, ahead_block, AHEAD_BLOCK);
 
-            delayL[delay_idx] = mixL;
-            delayR[delay_idx] = mixR;
+        double render = (double)(SDL_GetPerformanceCounter() - t0) /
+                        (double)SDL_GetPerformanceFrequency();
+        int tier = governor_update(&governor, render, deadline);
+        governor_apply(tier, render > deadline * GOV_HIGH);
+    }
+    return 0;
+}
 
-            mixL = mixL * 0.7f + dl * 0.3f;
-            mixR = mixR * 0.7f + dr * 0.3f;
+static int render_thread_start(void)
+{
+    ahead_frames = ahead_blocks * AHEAD_BLOCK;
+    frame_ring_init(&ahead_ring);
+
+    render_wake = SDL_CreateSemaphore(0);
+    if (!render_wake)
+        return -1;
+
+    SDL_AtomicSet(&render_run, 1);
+    render_thread = SDL_CreateThread(render_thread_main, "render", NULL);
+    if (!render_thread) {
+        SDL_DestroySemaphore(render_wake);
+        return -1;
+    }
+    return 0;
+}
 
-            delay_idx = (delay_idx + 1) % DELAY_BUF_SIZE;
-        }
+static void render_thread_stop(void)
+{
+    if (!render_thread)
+        return;
+    SDL_AtomicSet(&render_run, 0);
+    SDL_SemPost(render_wake);
+    SDL_WaitThread(render_thread, NULL);
+    SDL_DestroySemaphore(render_wake);
+    render_thread = NULL;
+}
+
+/* stamps an event for the engine. Direct rendering applies it at the
+   next callback as before; render-ahead places it a fixed latency after
+   the frame the device is playing now, so timing between events holds */
+static void engine_send(Event e)
+{
+    static Uint32 last;
+
+    Uint32 now = (Uint32)SDL_AtomicGet(&play_frame);
+    if (ahead_blocks) {
+        Uint32 ms = SDL_GetTicks() - (Uint32)SDL_AtomicGet(&play_ticks);
+        Uint32 into = (Uint32)((Uint64)ms * SAMPLE_RATE / 1000);
+        if (into > (Uint32)device_frames) into = (Uint32)device_frames;
+        now += into + (Uint32)ahead_frames;
+    }
+    if ((int)(now - last) < 0)
+        now = last;
+    last = now;
+
+    e.frame = now;
+    if (event_push(&events, &e) != 0)
+        printf("event queue full, event dropped\n");
+}
+
+void audio_cb(void *ud, Uint8 *stream, int len)
+{
+    int16_t *out = (int16_t*)stream;
+    int frames = len / (sizeof(int16_t) * 2);
+
+    if (rt_mode && SDL_AtomicGet(&rt_audio.state) == 0)
+        rt_thread_init(&rt_audio);
 
-        /* clamp */
-        if (mixL > 1.0f) mixL = 1.0f;
-        if (mixL < -1.0f) mixL = -1.0f;
-        if (mixR > 1.0f) mixR = 1.0f;
-        if (mixR < -1.0f) mixR = -1.0f;
+    SDL_AtomicSet(&play_ticks, (int)SDL_GetTicks());
 
-        out[i * 2 + 0] = (int16_t)(mixL * 32767);
-        out[i * 2 + 1] = (int16_t)(mixR * 32767);
+    if (ahead_blocks) {
+        /* the clock follows the ring, so an underrun cannot leave later
+           events stamped further ahead than ahead_frames */
+        int got = frame_ring_read(&ahead_ring, out, frames);
+        SDL_AtomicAdd(&play_frame, got);
+        if (got < frames) {
+            memset(out + got * 2, 0, (size_t)(frames - got) * 2 * sizeof(int16_t));
+            SDL_AtomicAdd(&ahead_underruns, 1);
+        }
+        SDL_SemPost(render_wake);
+        return;
     }
+
+    SDL_AtomicAdd(&play_frame, frames);
+
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    double deadline = (double)frames / SAMPLE_RATE;
+
+    engine_render(out, frames);
+
+    double render = (double)(SDL_GetPerformanceCounter() - t0) /
+                    (double)SDL_GetPerformanceFrequency();
+    int tier = governor_update(&governor, render, deadline);
+    governor_apply(tier, render > deadline * GOV_HIGH);
 }
 
 /* =========================
@@ -320,8 +896,13 @@ static void draw_glyph(SDL_Renderer *r, int x, int y, int s, char c)
         case 'U': rows[0]=0b101; rows[1]=0b101; rows[2]=0b101; rows[3]=0b101; rows[4]=0b111; break;
         case 'S': rows[0]=0b111; rows[1]=0b100; rows[2]=0b111; rows[3]=0b001; rows[4]=0b111; break;
         case 'T': rows[0]=0b111; rows[1]=0b010; rows[2]=0b010; rows[3]=0b010; rows[4]=0b010; break;
+        case 'P': rows[0]=0b110; rows[1]=0b101; rows[2]=0b110; rows[3]=0b100; rows[4]=0b100; break;
+        case 'I': rows[0]=0b111; rows[1]=0b010; rows[2]=0b010; rows[3]=0b010; rows[4]=0b111; break;
+        case 'N': rows[0]=0b110; rows[1]=0b101; rows[2]=0b101; rows[3]=0b101; rows[4]=0b101; break;
+        case 'X': rows[0]=0b101; rows[1]=0b101; rows[2]=0b010; rows[3]=0b101; rows[4]=0b101; break;
         case 'M': rows[0]=0b101; rows[1]=0b111; rows[2]=0b111; rows[3]=0b101; rows[4]=0b101; break;
         case 'L': rows[0]=0b100; rows[1]=0b100; rows[2]=0b100; rows[3]=0b100; rows[4]=0b111; break;
+        case 'V': rows[0]=0b101; rows[1]=0b101; rows[2]=0b101; rows[3]=0b101; rows[4]=0b010; break;
 
         case '#': rows[0]=0b101; rows[1]=0b111; rows[2]=0b101; rows[3]=0b111; rows[4]=0b101; break;
 
@@ -444,20 +1025,182 @@ static void draw_header(SDL_Renderer *r)
     SDL_SetRenderDrawColor(r, 240, 240, 240, 255);
     draw_text(r, 40, 22, 4, "WINDOWS-SYNTH");
     SDL_SetRenderDrawColor(r, 170, 170, 170, 255);
-    draw_text(r, 40, 52, 2, "1-8 NOTES  |  C CHORUS  |  T TREMOLO  |  SPACE ALL OFF  |  ESC QUIT");
+    draw_text(r, 40, 52, 2, "1-8 NOTES  |  C CHORUS  |  T TREMOLO  |  V REVERB  |  O ORDER  |  R REC  |  SPACE ALL OFF  |  ESC QUIT");
+
+    /* recording indicator, with the dropped block count if any */
+    if (recorder_active(&recorder)) {
+        SDL_Rect rec = { WINDOW_W - 230, 16, 190, 28 };
+        SDL_SetRenderDrawColor(r, 200, 40, 40, 255);
+        SDL_RenderFillRect(r, &rec);
+
+        char buf[32];
+        int dropped = recorder_dropped(&recorder);
+        if (dropped) snprintf(buf, sizeof(buf), "REC  DROP %d", dropped);
+        else         snprintf(buf, sizeof(buf), "REC");
+        SDL_SetRenderDrawColor(r, 240, 240, 240, 255);
+        draw_text(r, rec.x + 10, rec.y + 8, 2, buf);
+    }
+}
+
+static void toggle_recording(void)
+{
+    if (recorder_active(&recorder)) {
+        recorder_stop(&recorder);
+        printf("recording stopped: %.1f s, %d dropped blocks%s\n",
+               (double)recorder.data_bytes / (SAMPLE_RATE * 2 * sizeof(float)),
+               recorder_dropped(&recorder),
+               recorder.write_error ? ", WRITE ERROR" : "");
+        return;
+    }
+
+    char path[64];
+    time_t now = time(NULL);
+    strftime(path, sizeof(path), "session_%Y%m%d_%H%M%S.wav", localtime(&now));
+
+    if (recorder_start(&recorder, path, SAMPLE_RATE) == 0)
+        printf("recording to %s\n", path);
+    else
+        printf("cannot record to %s\n", path);
+}
+
+static void draw_status(SDL_Renderer *r)
+{
+    char buf[48];
+    if (ahead_blocks)
+        snprintf(buf, sizeof(buf), "UNISON %d  AHEAD %d  XRUN %d", uni_full.count, ahead_blocks,
+                 SDL_AtomicGet(&ahead_underruns));
+    else
+        snprintf(buf, sizeof(buf), "UNISON %d", uni_full.count);
+    SDL_SetRenderDrawColor(r, 170, 170, 170, 255);
+    draw_text(r, 40, 94, 2, buf);
+
+    /* governor: load and quality tier, highlighted once it degrades */
+    int tier = governor.tier;
+    snprintf(buf, sizeof(buf), "LOAD %d  %s", (int)(governor.load * 100.0f),
+             governor_tier_name(tier));
+    if (tier == GOV_FULL)       SDL_SetRenderDrawColor(r, 170, 170, 170, 255);
+    else if (tier < GOV_STEAL)  SDL_SetRenderDrawColor(r, 230, 170, 60, 255);
+    else                        SDL_SetRenderDrawColor(r, 220, 60, 60, 255);
+    draw_text(r, WINDOW_W - 40 - ((int)strlen(buf) * 8 - 2), 94, 2, buf);
 }
 
 static void draw_fx(SDL_Renderer *r)
 {
-    SDL_Rect chorus = { WINDOW_W/2 - 170, 318, 150, 32 };
-    SDL_Rect trem   = { WINDOW_W/2 +  20, 318, 150, 32 };
+    /* one button per node, left to right in processing order */
+    const int btn_w = 150, gap = 20;
+    int x = (WINDOW_W - fx.count * btn_w - (fx.count - 1) * gap) / 2;
 
-    draw_button(r, chorus, chorus_on);
-    draw_button(r, trem, tremolo_on);
+    for (int i = 0; i < fx.count; i++) {
+        const FxNode *n = &fx.nodes[fx.order[i]];
+        SDL_Rect rc = { x, 318, btn_w, 32 };
 
-    SDL_SetRenderDrawColor(r, 240, 240, 240, 255);
-    draw_text(r, chorus.x + 20, chorus.y + 9, 2, "CHORUS");
-    draw_text(r, trem.x + 18,   trem.y + 9,   2, "TREMOLO");
+        draw_button(r, rc, !n->bypass);
+
+        int text_w = (int)strlen(n->name) * 8 - 2;
+        SDL_SetRenderDrawColor(r, 240, 240, 240, 255);
+        draw_text(r, rc.x + (btn_w - text_w) / 2, rc.y + 9, 2, n->name);
+
+        x += btn_w + gap;
+    }
+}
+
+/* =========================
+   BENCHMARK (--bench)
+   Times render_block with BENCH_VOICES notes at every unison count,
+   over the attack (with and without the attack cache) and once the
+   voices are held, then reverb_process on
+   its own at full and lite size. No window or audio device is opened.
+========================= */
+#define BENCH_VOICES 64
+#define BENCH_ATTACK 16        /* blocks timed right after note on */
+#define BENCH_SETTLE 64        /* blocks before the held timing starts */
+#define BENCH_BLOCKS 64         /* per run; held and reverb report the best run */
+#define BENCH_RUNS   8
+
+static double bench_blocks(int blocks)
+{
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    for (int b = 0; b < blocks; b++)
+        render_block(blockL, blockR, BLOCK_SIZE);
+    double s = (double)(SDL_GetPerformanceCounter() - t0) /
+               (double)SDL_GetPerformanceFrequency();
+    return s * 1e6 / blocks;
+}
+
+/* fresh notes, best of BENCH_RUNS; leaves the voices sounding */
+static double bench_attack(int cached)
+{
+    double best = 1e9;
+
+    attack_cache_on = cached;
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        voices_init();
+        for (int v = 0; v < BENCH_VOICES; v++)
+            note_on(note_freqs[v % NUM_NOTES], -1, 0);
+
+        double us = bench_blocks(BENCH_ATTACK);
+        if (us < best) best = us;
+    }
+    return best;
+}
+
+static int run_bench(void)
+{
+    int cache = attack_cache_on;
+
+    envelopes_init();
+    attack_cache_init();
+    engine_patch = patch;
+
+    printf("bench: %d voices, %d-frame blocks (%.0f us of audio each)\n",
+           BENCH_VOICES, BLOCK_SIZE, 1e6 * BLOCK_SIZE / SAMPLE_RATE);
+    printf("unison  cached attack  live attack    held  (us per block)\n");
+
+    for (int n = 1; n <= MAX_UNISON; n++) {
+        engine_patch.unison = n;
+        patch_apply(&engine_patch);
+
+        double live = bench_attack(0);
+        double cached = bench_attack(1);
+        attack_cache_on = cache;
+
+        bench_blocks(BENCH_SETTLE);
+        double held = 1e9;
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            double us = bench_blocks(BENCH_BLOCKS);
+            if (us < held) held = us;
+        }
+        printf("%6d  %13.1f  %11.1f  %6.1f\n", n, cached, live, held);
+    }
+
+    /* reverb: same block size, fed noise so no line is idle. The input
+       is copied in each block (it is processed in place); the copy is
+       timed too but is small next to the reverb */
+    Uint32 seed = 1;
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        seed = seed * 214013u + 2531011u;
+        voice_cum[i] = (float)((seed >> 16) & 0x7FFF) / 16384.0f - 1.0f;
+    }
+
+    for (int lite = 0; lite <= 1; lite++) {
+        reverb_init(&reverb, SAMPLE_RATE, REVERB_DECAY, REVERB_DAMP, REVERB_MIX);
+        reverb_set_lite(&reverb, lite);
+
+        double best = 1e9;
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            Uint64 t0 = SDL_GetPerformanceCounter();
+            for (int b = 0; b < BENCH_BLOCKS; b++) {
+                memcpy(blockL, voice_cum, sizeof(blockL));
+                memcpy(blockR, voice_cum, sizeof(blockR));
+                reverb_process(&reverb, blockL, blockR, BLOCK_SIZE);
+            }
+            double us = (double)(SDL_GetPerformanceCounter() - t0) * 1e6 /
+                        (double)SDL_GetPerformanceFrequency() / BENCH_BLOCKS;
+            if (us < best) best = us;
+        }
+        printf("reverb, %d lines  %10.1f us/block\n", reverb.lines, best);
+    }
+    return 0;
 }
 
 /* =========================
@@ -465,6 +1208,31 @@ static void draw_fx(SDL_Renderer *r)
 ========================= */
 int main(int argc, char *argv[])
 {
+    int bench = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-attack-cache") == 0)
+            attack_cache_on = 0;
+        if (strcmp(argv[i], "--bench") == 0)
+            bench = 1;
+        if (strcmp(argv[i], "--rt") == 0)
+            rt_mode = 1;
+        if (strcmp(argv[i], "--render-ahead") == 0 && i + 1 < argc) {
+            ahead_blocks = atoi(argv[++i]);
+            if (ahead_blocks < 1 || ahead_blocks > AHEAD_MAX_BLOCKS) {
+                printf("--render-ahead takes 1 to %d blocks of %d frames\n",
+                       AHEAD_MAX_BLOCKS, AHEAD_BLOCK);
+                return 1;
+            }
+        }
+    }
+
+    if (bench)
+        return run_bench();
+
+    if (rt_mode)
+        rt_set_hints();
+
     if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO) != 0) {
         printf("SDL_Init failed: %s\n", SDL_GetError());
         return 1;
@@ -477,6 +1245,32 @@ int main(int argc, char *argv[])
 
     SDL_Renderer *ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED);
 
+    tremolo_init(&tremolo, SAMPLE_RATE, TREM_RATE, TREM_DEPTH);
+    chorus_init(&chorus, SAMPLE_RATE, CHORUS_RATE, CHORUS_DELAY, CHORUS_DEPTH);
+    reverb_init(&reverb, SAMPLE_RATE, REVERB_DECAY, REVERB_DAMP, REVERB_MIX);
+
+    voices_init();
+    envelopes_init();
+    governor_init(&governor);
+    engine_patch = patch;
+    patch_apply(&engine_patch);
+    event_queue_init(&events);
+    event_queue_init(&notices);
+    if (attack_cache_on)
+        attack_cache_init();
+
+    fx_chain_init(&fx);
+    fx_tremolo_id = fx_chain_add(&fx, "TREMOLO", fx_tremolo, &tremolo);
+    fx_chorus_id  = fx_chain_add(&fx, "CHORUS",  fx_chorus,  &chorus);
+    fx_reverb_id  = fx_chain_add(&fx, "REVERB",  fx_reverb,  &reverb);
+
+    if (rt_mode) {
+        char msg[96];
+        rt_lock_memory(msg, sizeof(msg));
+        printf("rt: %s\n", msg);
+        printf("rt: prefaulted %u KB of DSP buffers\n", (unsigned)(rt_prefault_dsp() / 1024));
+    }
+
     SDL_AudioSpec want;
     SDL_zero(want);
     want.freq = SAMPLE_RATE;
@@ -485,15 +1279,57 @@ int main(int argc, char *argv[])
     want.samples = 512;
     want.callback = audio_cb;
 
-    SDL_AudioDeviceID dev = SDL_OpenAudioDevice(NULL, 0, &want, NULL, 0);
+    SDL_AudioSpec have;
+    SDL_AudioDeviceID dev = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
     if (!dev) {
         printf("SDL_OpenAudioDevice failed: %s\n", SDL_GetError());
         return 1;
     }
+    device_frames = have.samples;
+
+    if (ahead_blocks) {
+        /* a block must be able to render while a whole device buffer
+           is still queued, or every refill races the next callback */
+        int need = (device_frames + 2 * AHEAD_BLOCK - 1) / AHEAD_BLOCK;
+        if (need > AHEAD_MAX_BLOCKS) {
+            printf("render-ahead: a %d-frame device buffer needs more than %d blocks\n",
+                   device_frames, AHEAD_MAX_BLOCKS);
+            return 1;
+        }
+        if (ahead_blocks < need) {
+            printf("render-ahead: raised to %d blocks to cover the %d-frame device buffer\n",
+                   need, device_frames);
+            ahead_blocks = need;
+        }
+
+        if (render_thread_start() != 0) {
+            printf("cannot start render thread: %s\n", SDL_GetError());
+            return 1;
+        }
+        printf("render-ahead: %d x %d frames (%.1f ms)\n", ahead_blocks, AHEAD_BLOCK,
+               1000.0 * ahead_frames / SAMPLE_RATE);
+
+        /* the ring is full before the device pulls its first buffer */
+        while (frame_ring_fill(&ahead_ring) < ahead_frames)
+            SDL_Delay(1);
+    }
     SDL_PauseAudioDevice(dev, 0);
 
     SDL_Event e;
     while (running) {
+        if (rt_mode) {
+            rt_thread_log(&rt_audio);
+            rt_thread_log(&rt_render);
+        }
+
+        /* keys whose voice the governor stole, unless pressed again since */
+        const Event *n;
+        while ((n = event_peek(&notices))) {
+            if (n->type == EV_STOLEN && note_gen[n->a] == n->b)
+                note_active[n->a] = 0;
+            event_pop(&notices);
+        }
+
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) running = 0;
 
@@ -503,19 +1339,33 @@ int main(int argc, char *argv[])
                 if (k == SDLK_ESCAPE) running = 0;
 
                 if (k == SDLK_SPACE) {
-                    all_notes_off();
+                    engine_send((Event){ .type = EV_ALL_OFF });
                     for (int i = 0; i < NUM_NOTES; i++) note_active[i] = 0;
                 }
 
                 if (k >= SDLK_1 && k <= SDLK_8) {
                     int i = (int)(k - SDLK_1);
                     note_active[i] ^= 1;
-                    if (note_active[i]) note_on(note_freqs[i]);
-                    else                note_off(note_freqs[i]);
+                    if (note_active[i]) note_gen[i]++;
+                    engine_send((Event){ .type = note_active[i] ? EV_NOTE_ON : EV_NOTE_OFF,
+                                         .f = note_freqs[i], .a = i, .b = note_gen[i] });
+                }
+
+                if (k == SDLK_c) engine_send((Event){ .type = EV_BYPASS, .a = fx_chorus_id });
+                if (k == SDLK_t) engine_send((Event){ .type = EV_BYPASS, .a = fx_tremolo_id });
+                if (k == SDLK_v) engine_send((Event){ .type = EV_BYPASS, .a = fx_reverb_id });
+                if (k == SDLK_r) toggle_recording();
+
+                if (k == SDLK_LEFTBRACKET || k == SDLK_RIGHTBRACKET) {
+                    patch.unison += (k == SDLK_RIGHTBRACKET) ? 1 : -1;
+                    if (patch.unison < 1) patch.unison = 1;
+                    if (patch.unison > MAX_UNISON) patch.unison = MAX_UNISON;
+                    engine_send((Event){ .type = EV_UNISON, .a = patch.unison });
                 }
 
-                if (k == SDLK_c) chorus_on  ^= 1;
-                if (k == SDLK_t) tremolo_on ^= 1;
+                /* rotate the chain: first node moves to the end */
+                if (k == SDLK_o)
+                    engine_send((Event){ .type = EV_FX_MOVE, .a = 0, .b = fx.count - 1 });
             }
         }
 
@@ -523,6 +1373,7 @@ int main(int argc, char *argv[])
         SDL_RenderClear(ren);
 
         draw_header(ren);
+        draw_status(ren);
         draw_keyboard(ren);
         draw_fx(ren);
 
@@ -531,6 +1382,10 @@ int main(int argc, char *argv[])
     }
 
     SDL_CloseAudioDevice(dev);
+    render_thread_stop();
+    if (ahead_blocks)
+        printf("render-ahead: %d underruns\n", SDL_AtomicGet(&ahead_underruns));
+    recorder_stop(&recorder);
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     SDL_Quit();
@@ -0,0 +1,126 @@
+#include "recorder.h"
+#include "wav.h"
+
+/* =========================
+   AUDIO THREAD SIDE
+========================= */
+void recorder_push(Recorder *r, const float *L, const float *R, int frames) {
+    if (!SDL_AtomicGet(&r->recording))
+        return;
+
+    while (frames > 0) {
+        int n = (frames < REC_BLOCK_FRAMES) ? frames : REC_BLOCK_FRAMES;
+        int head = SDL_AtomicGet(&r->head);
+        int tail = SDL_AtomicGet(&r->tail);
+
+        if (head - tail >= REC_RING_BLOCKS) {
+            SDL_AtomicAdd(&r->dropped, 1);
+        }
+        else {
+            int slot = head & (REC_RING_BLOCKS - 1);
+            float *dst = r->data[slot];
+            for (int i = 0; i < n; i++) {
+                dst[i * 2 + 0] = L[i];
+                dst[i * 2 + 1] = R[i];
+            }
+            r->frames[slot] = n;
+
+            SDL_MemoryBarrierRelease();
+            SDL_AtomicSet(&r->head, head + 1);
+        }
+
+        L += n;
+        R += n;
+        frames -= n;
+    }
+}
+
+/* =========================
+   WRITER THREAD
+========================= */
+static int writer(void *ud) {
+    Recorder *r = ud;
+
+    for (;;) {
+        int head = SDL_AtomicGet(&r->head);
+        int tail = SDL_AtomicGet(&r->tail);
+
+        if (head == tail) {
+            /* stop only once everything pushed so far is on disk */
+            if (!SDL_AtomicGet(&r->recording) && head == SDL_AtomicGet(&r->head))
+                break;
+            SDL_Delay(10);
+            continue;
+        }
+
+        SDL_MemoryBarrierAcquire();
+        while (tail != head) {
+            int slot = tail & (REC_RING_BLOCKS - 1);
+            size_t n = (size_t)r->frames[slot] * 2;
+
+            if (!r->write_error && fwrite(r->data[slot], sizeof(float), n, r->file) != n)
+                r->write_error = 1;
+            r->data_bytes += n * sizeof(float);
+
+            tail++;
+            SDL_AtomicSet(&r->tail, tail);
+        }
+    }
+    return 0;
+}
+
+/* =========================
+   CONTROL (UI thread)
+========================= */
+int recorder_start(Recorder *r, const char *path, int sample_rate) {
+    if (r->thread)
+        return -1;
+
+    r->file = fopen(path, "wb");
+    if (!r->file)
+        return -1;
+    setvbuf(r->file, NULL, _IOFBF, REC_FILE_BUFFER);
+
+    r->sample_rate = sample_rate;
+    r->data_bytes = 0;
+    r->write_error = wav_write_long_header(r->file, sample_rate, 2, WAV_FLOAT, 0) != 0;
+
+    SDL_AtomicSet(&r->head, 0);
+    SDL_AtomicSet(&r->tail, 0);
+    SDL_AtomicSet(&r->dropped, 0);
+    SDL_AtomicSet(&r->recording, 1);
+
+    r->thread = SDL_CreateThread(writer, "recorder", r);
+    if (!r->thread) {
+        SDL_AtomicSet(&r->recording, 0);
+        fclose(r->file);
+        r->file = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void recorder_stop(Recorder *r) {
+    if (!r->thread)
+        return;
+
+    SDL_AtomicSet(&r->recording, 0);
+    SDL_WaitThread(r->thread, NULL);
+    r->thread = NULL;
+
+    /* final sizes go back into the reserved header */
+    if (fseek(r->file, 0, SEEK_SET) != 0 ||
+        wav_write_long_header(r->file, r->sample_rate, 2, WAV_FLOAT, r->data_bytes) != 0)
+        r->write_error = 1;
+    if (fclose(r->file) != 0)
+        r->write_error = 1;
+    r->file = NULL;
+}
+
+int recorder_active(Recorder *r) {
+    return r->thread != NULL;
+}
+
+int recorder_dropped(Recorder *r) {
+    return SDL_AtomicGet(&r->dropped);
+}
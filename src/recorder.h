@@ -0,0 +1,39 @@
+#pragma once
+#include <SDL.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* =========================
+   SESSION RECORDER
+   The audio thread copies each finished stereo block into a
+   preallocated single-producer / single-consumer ring and never waits;
+   a normal-priority writer thread drains the ring to a float WAV.
+   Blocks that find the ring full are counted as dropped.
+========================= */
+#define REC_BLOCK_FRAMES 256
+#define REC_RING_BLOCKS  1024              /* ~6 s at 44.1 kHz; power of two */
+#define REC_FILE_BUFFER  (4 << 20)
+
+typedef struct {
+    float data[REC_RING_BLOCKS][REC_BLOCK_FRAMES * 2];
+    int   frames[REC_RING_BLOCKS];
+
+    SDL_atomic_t head;          /* next slot the audio thread fills */
+    SDL_atomic_t tail;          /* next slot the writer drains */
+    SDL_atomic_t recording;
+    SDL_atomic_t dropped;       /* blocks lost to a full ring */
+
+    SDL_Thread *thread;
+    FILE *file;
+    int sample_rate;
+    uint64_t data_bytes;
+    int write_error;
+} Recorder;
+
+int  recorder_start(Recorder *r, const char *path, int sample_rate);
+void recorder_stop(Recorder *r);
+int  recorder_active(Recorder *r);
+int  recorder_dropped(Recorder *r);
+
+/* audio thread only */
+void recorder_push(Recorder *r, const float *L, const float *R, int frames);
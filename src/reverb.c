@@ -0,0 +1,146 @@
+#include "reverb.h"
+#include <math.h>
+#include <string.h>
+
+/* mutually prime line lengths at 44.1 kHz (~23..66 ms) */
+static const int base_len[REVERB_LINES] = {
+    1031, 1327, 1523, 1801, 2053, 2311, 2579, 2917
+};
+
+void reverb_clear(Reverb *r) {
+    memset(r->buf, 0, sizeof(r->buf));
+    memset(r->lp, 0, sizeof(r->lp));
+    r->pos = 0;
+}
+
+void reverb_init(Reverb *r, int sample_rate, float decay_s, float damp, float mix) {
+    for (int i = 0; i < REVERB_LINES; i++) {
+        int n = (int)((float)base_len[i] * sample_rate / 44100.0f);
+        if (n < 1) n = 1;
+        if (n > REVERB_MASK) n = REVERB_MASK;
+        r->len[i] = n;
+
+        /* -60 dB after decay_s seconds */
+        r->fb[i] = powf(10.0f, -3.0f * (float)n / ((float)sample_rate * decay_s));
+    }
+    r->damp = damp;
+    r->mix  = mix;
+    r->lines = REVERB_LINES;
+
+    r->block = REVERB_BLOCK;
+    for (int i = 0; i < REVERB_LINES; i++)
+        if (r->len[i] < r->block)
+            r->block = r->len[i];
+
+    reverb_clear(r);
+}
+
+/* lite mode runs only the first REVERB_LITE lines; the others are
+   cleared on the way back so no stale tail resurfaces */
+void reverb_set_lite(Reverb *r, int lite) {
+    int lines = lite ? REVERB_LITE : REVERB_LINES;
+    if (lines == r->lines)
+        return;
+
+    for (int i = REVERB_LITE; i < REVERB_LINES; i++) {
+        memset(r->buf[i], 0, sizeof(r->buf[i]));
+        r->lp[i] = 0.0f;
+    }
+    r->lines = lines;
+}
+
+/* copies n samples starting at buffer index start, across the wrap */
+static void ring_read(float *dst, const float *buf, int start, int n) {
+    int first = REVERB_BUF_LEN - start;
+    if (first > n) first = n;
+    memcpy(dst, buf + start, first * sizeof(float));
+    memcpy(dst + first, buf, (n - first) * sizeof(float));
+}
+
+/* one pass of n <= r->block frames. Every step but the damping runs
+   frame-wise over the whole pass for each line, so it vectorizes; the
+   arithmetic per frame is the same as stepping one frame at a time */
+static void reverb_block(Reverb *r, float *L, float *R, int n) {
+    const float damp = r->damp;
+    const int lines = r->lines;
+    const float norm = 1.0f / sqrtf((float)lines);
+    const float mix  = r->mix * 2.0f / lines;   /* lines / 2 taps per side */
+    const int pos = r->pos;
+
+    float y[REVERB_LINES][REVERB_BLOCK];
+    float in[REVERB_BLOCK];
+    float wetL[REVERB_BLOCK], wetR[REVERB_BLOCK];
+
+    /* n is no longer than any line, so all of this was written earlier */
+    for (int i = 0; i < lines; i++)
+        ring_read(y[i], r->buf[i], (pos - r->len[i]) & REVERB_MASK, n);
+
+    /* damping low-pass inside the loop; serial in time, one line at a time */
+    for (int i = 0; i < lines; i++) {
+        float lp = r->lp[i];
+        for (int f = 0; f < n; f++) {
+            lp += (y[i][f] - lp) * (1.0f - damp);
+            y[i][f] = lp;
+        }
+        r->lp[i] = lp;
+    }
+
+    for (int f = 0; f < n; f++) {
+        wetL[f] = 0.0f;
+        wetR[f] = 0.0f;
+    }
+    for (int i = 0; i < lines; i += 2) {
+        for (int f = 0; f < n; f++) {
+            wetL[f] += y[i][f];
+            wetR[f] += y[i + 1][f];
+        }
+    }
+
+    /* in-place fast Walsh-Hadamard across lines, each butterfly a pair
+       of whole rows; the norm that keeps it lossless is applied on the
+       write-back */
+    for (int h = 1; h < lines; h <<= 1) {
+        for (int i = 0; i < lines; i += h << 1) {
+            for (int j = i; j < i + h; j++) {
+                for (int f = 0; f < n; f++) {
+                    float a = y[j][f];
+                    float b = y[j + h][f];
+                    y[j][f]     = a + b;
+                    y[j + h][f] = a - b;
+                }
+            }
+        }
+    }
+
+    for (int f = 0; f < n; f++)
+        in[f] = (L[f] + R[f]) * 0.5f;
+
+    /* write back as at most two contiguous runs around the wrap */
+    int first = REVERB_BUF_LEN - pos;
+    if (first > n) first = n;
+    for (int i = 0; i < lines; i++) {
+        float *dst = r->buf[i];
+        const float g = r->fb[i];
+        for (int f = 0; f < first; f++)
+            dst[pos + f] = in[f] + y[i][f] * norm * g;
+        for (int f = first; f < n; f++)
+            dst[f - first] = in[f] + y[i][f] * norm * g;
+    }
+
+    for (int f = 0; f < n; f++) {
+        L[f] += wetL[f] * mix;
+        R[f] += wetR[f] * mix;
+    }
+
+    r->pos = (pos + n) & REVERB_MASK;
+}
+
+void reverb_process(Reverb *r, float *L, float *R, int frames) {
+    while (frames > 0) {
+        int n = (frames < r->block) ? frames : r->block;
+        reverb_block(r, L, R, n);
+        L += n;
+        R += n;
+        frames -= n;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+/* =========================
+   FDN REVERB
+   8 delay lines, Hadamard feedback matrix, one-pole damping per line.
+   Every line shares one power-of-two buffer length so the read/write
+   wrap is a single mask. Audio is processed in passes no longer than
+   the shortest line, so a pass only reads samples written before it
+   and each line's output is one contiguous run of its buffer.
+========================= */
+#define REVERB_LINES   8
+#define REVERB_LITE    4               /* lines kept in lite mode */
+#define REVERB_BUF_LEN 4096            /* power of two */
+#define REVERB_MASK    (REVERB_BUF_LEN - 1)
+#define REVERB_BLOCK   256             /* longest pass, in frames */
+
+typedef struct {
+    float buf[REVERB_LINES][REVERB_BUF_LEN];
+
+    int   len[REVERB_LINES];    /* delay per line, in samples */
+    float fb[REVERB_LINES];     /* feedback gain for the decay time */
+    float lp[REVERB_LINES];     /* damping filter state */
+
+    float damp;                 /* 0 = bright .. 1 = dark */
+    float mix;                  /* wet level added to the dry signal */
+    int   pos;
+    int   lines;                /* REVERB_LINES, or REVERB_LITE to save CPU */
+    int   block;                /* pass length: REVERB_BLOCK or the shortest line */
+} Reverb;
+
+void reverb_init(Reverb *r, int sample_rate, float decay_s, float damp, float mix);
+void reverb_clear(Reverb *r);
+void reverb_set_lite(Reverb *r, int lite);
+void reverb_process(Reverb *r, float *L, float *R, int frames);
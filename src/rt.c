@@ -0,0 +1,121 @@
+#include "rt.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#define RT_FIFO_PRIORITY 70
+#define RT_PAGE_SIZE     4096
+
+void rt_set_hints(void) {
+#ifdef SDL_HINT_THREAD_PRIORITY_POLICY
+    SDL_SetHint(SDL_HINT_THREAD_PRIORITY_POLICY, "fifo");
+#endif
+#ifdef SDL_HINT_THREAD_FORCE_REALTIME_TIME_CRITICAL
+    SDL_SetHint(SDL_HINT_THREAD_FORCE_REALTIME_TIME_CRITICAL, "1");
+#endif
+}
+
+int rt_lock_memory(char *msg, size_t len) {
+#ifdef __linux__
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        snprintf(msg, len, "mlockall failed: %s", strerror(errno));
+        return -1;
+    }
+    snprintf(msg, len, "mlockall ok");
+    return 0;
+#else
+    snprintf(msg, len, "memory locking not supported on this platform");
+    return -1;
+#endif
+}
+
+void rt_prefault(void *p, size_t bytes) {
+    volatile char *c = p;
+
+    /* read and write back, so pages are resident and writable
+       without changing their contents */
+    for (size_t i = 0; i < bytes; i += RT_PAGE_SIZE)
+        c[i] = c[i];
+    if (bytes)
+        c[bytes - 1] = c[bytes - 1];
+}
+
+void rt_prefault_stack(size_t bytes) {
+    char buf[bytes];
+    volatile char *c = buf;
+    for (size_t i = 0; i < bytes; i += RT_PAGE_SIZE)
+        c[i] = 0;
+}
+
+int rt_promote_thread(char *msg, size_t len) {
+#ifdef __linux__
+    struct sched_param sp;
+    int policy;
+
+    /* SDL may already have done it, through the hints above */
+    if (pthread_getschedparam(pthread_self(), &policy, &sp) == 0 &&
+        (policy == SCHED_FIFO || policy == SCHED_RR)) {
+        snprintf(msg, len, "%s priority %d (set by SDL)",
+                 policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", sp.sched_priority);
+        return 0;
+    }
+
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = RT_FIFO_PRIORITY;
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    if (err == 0) {
+        snprintf(msg, len, "SCHED_FIFO priority %d", RT_FIFO_PRIORITY);
+        return 0;
+    }
+
+    /* no RLIMIT_RTPRIO: let SDL go through rtkit */
+    if (SDL_SetThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL) == 0 &&
+        pthread_getschedparam(pthread_self(), &policy, &sp) == 0 &&
+        (policy == SCHED_FIFO || policy == SCHED_RR)) {
+        snprintf(msg, len, "%s priority %d via rtkit",
+                 policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", sp.sched_priority);
+        return 0;
+    }
+
+    snprintf(msg, len, "SCHED_FIFO failed (%s), rtkit unavailable", strerror(err));
+    return -1;
+#else
+    if (SDL_SetThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL) == 0) {
+        snprintf(msg, len, "time-critical priority");
+        return 0;
+    }
+    snprintf(msg, len, "priority change failed: %s", SDL_GetError());
+    return -1;
+#endif
+}
+
+int rt_enable_ftz(char *msg, size_t len) {
+#if defined(__SSE__)
+    /* MXCSR bit 15 = FTZ, bit 6 = DAZ */
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+    snprintf(msg, len, "FTZ/DAZ on (MXCSR %04x)", _mm_getcsr());
+    return 0;
+#elif defined(__aarch64__)
+    unsigned long fpcr;
+    __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr |= 1ul << 24;   /* FZ */
+    __asm__ volatile("msr fpcr, %0" : : "r"(fpcr));
+    snprintf(msg, len, "flush-to-zero on (FPCR.FZ)");
+    return 0;
+#else
+    snprintf(msg, len, "flush-to-zero not supported on this CPU");
+    return -1;
+#endif
+}
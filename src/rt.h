@@ -0,0 +1,28 @@
+#pragma once
+#include <stddef.h>
+
+/* =========================
+   REAL-TIME MODE (opt-in)
+   Helpers for running the audio path without page faults, priority
+   inversion or denormal slow paths. Each returns 0 on success so the
+   caller can log what actually took effect.
+========================= */
+
+/* asks SDL to use SCHED_FIFO (or rtkit) for time-critical threads;
+   call before SDL_Init */
+void rt_set_hints(void);
+
+/* mlockall the process (Linux); writes a short status into msg */
+int rt_lock_memory(char *msg, size_t len);
+
+/* touches every page of a buffer so the first real access cannot fault */
+void rt_prefault(void *p, size_t bytes);
+
+/* touches the calling thread's stack down to the given depth */
+void rt_prefault_stack(size_t bytes);
+
+/* raises the calling thread to real-time priority */
+int rt_promote_thread(char *msg, size_t len);
+
+/* flush-to-zero / denormals-are-zero for the calling thread */
+int rt_enable_ftz(char *msg, size_t len);
@@ -1,6 +1,5 @@
 #include "synth.h"
 #include <math.h>
-#include <stdlib.h>
 
 static float square(float p) {
     return fmodf(p, 1.0f) < 0.25f ? 1.0f : -1.0f;
@@ -11,16 +10,23 @@ static float triangle(float p) {
     return 4.0f * fabsf(x - 0.5f) - 1.0f;
 }
 
-static float noise() {
-    return ((rand() & 0x7FFF) / 16384.0f) - 1.0f;
+/* msvcrt rand() sequence, with the state kept in the Synth */
+static float noise(Synth *s) {
+    s->noise_seed = s->noise_seed * 214013u + 2531011u;
+    return (((s->noise_seed >> 16) & 0x7FFF) / 16384.0f) - 1.0f;
 }
 
 void synth_init(Synth *s) {
     for (int i = 0; i < MAX_VOICES; i++)
         s->voices[i].active = 0;
+    s->noise_seed = 1;
 }
 
 void synth_trigger(Synth *s, float freq, int wf) {
+    synth_trigger_decay(s, freq, wf, 0.88f);
+}
+
+void synth_trigger_decay(Synth *s, float freq, int wf, float amp_decay) {
     for (int i = 0; i < MAX_VOICES; i++) {
         Voice *v = &s->voices[i];
         if (!v->active) {
@@ -28,7 +34,7 @@ void synth_trigger(Synth *s, float freq, int wf) {
             v->pitch = freq * 8.0f;
             v->pitch_decay = 0.92f;
             v->amp = 1.0f;
-            v->amp_decay = 0.88f;
+            v->amp_decay = amp_decay;
             v->waveform = wf;
             v->active = 1;
             return;
@@ -46,7 +52,7 @@ float synth_sample(Synth *s) {
         float smp = 0.0f;
         if (v->waveform == 0) smp = square(v->phase);
         else if (v->waveform == 1) smp = triangle(v->phase);
-        else smp = noise();
+        else smp = noise(s);
 
         mix += smp * v->amp;
 
@@ -60,3 +66,10 @@ float synth_sample(Synth *s) {
 
     return mix * 0.25f;
 }
+
+int synth_active(const Synth *s) {
+    for (int i = 0; i < MAX_VOICES; i++)
+        if (s->voices[i].active)
+            return 1;
+    return 0;
+}
@@ -16,8 +16,11 @@ typedef struct {
 
 typedef struct {
     Voice voices[MAX_VOICES];
+    unsigned int noise_seed;   /* per-instance, so instances can run on any thread */
 } Synth;
 
 void synth_init(Synth *s);
 void synth_trigger(Synth *s, float freq, int waveform);
+void synth_trigger_decay(Synth *s, float freq, int waveform, float amp_decay);
 float synth_sample(Synth *s);
+int synth_active(const Synth *s);
@@ -0,0 +1,79 @@
+#include "wav.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+int wav_write_header(FILE *f, int sample_rate, int channels, int format,
+                     uint32_t data_bytes) {
+    int bytes = (format == WAV_FLOAT) ? 4 : 2;
+    uint8_t h[WAV_HEADER_SIZE];
+
+    memcpy(h + 0, "RIFF", 4);
+    put_u32(h + 4, 36 + data_bytes);
+    memcpy(h + 8, "WAVE", 4);
+
+    memcpy(h + 12, "fmt ", 4);
+    put_u32(h + 16, 16);
+    put_u16(h + 20, format);
+    put_u16(h + 22, channels);
+    put_u32(h + 24, sample_rate);
+    put_u32(h + 28, sample_rate * channels * bytes);
+    put_u16(h + 32, channels * bytes);
+    put_u16(h + 34, bytes * 8);
+
+    memcpy(h + 36, "data", 4);
+    put_u32(h + 40, data_bytes);
+
+    return fwrite(h, 1, sizeof(h), f) == sizeof(h) ? 0 : -1;
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+int wav_write_long_header(FILE *f, int sample_rate, int channels, int format,
+                          uint64_t data_bytes) {
+    int bytes = (format == WAV_FLOAT) ? 4 : 2;
+    uint64_t riff_bytes = WAV_LONG_HEADER_SIZE - 8 + data_bytes;
+    int rf64 = riff_bytes > 0xFFFFFFFFu;
+    uint8_t h[WAV_LONG_HEADER_SIZE];
+
+    memset(h, 0, sizeof(h));
+    memcpy(h + 0, rf64 ? "RF64" : "RIFF", 4);
+    put_u32(h + 4, rf64 ? 0xFFFFFFFFu : (uint32_t)riff_bytes);
+    memcpy(h + 8, "WAVE", 4);
+
+    memcpy(h + 12, rf64 ? "ds64" : "JUNK", 4);
+    put_u32(h + 16, 28);
+    if (rf64) {
+        put_u64(h + 20, riff_bytes);
+        put_u64(h + 28, data_bytes);
+        put_u64(h + 36, data_bytes / (channels * bytes));
+        put_u32(h + 44, 0);
+    }
+
+    memcpy(h + 48, "fmt ", 4);
+    put_u32(h + 52, 16);
+    put_u16(h + 56, format);
+    put_u16(h + 58, channels);
+    put_u32(h + 60, sample_rate);
+    put_u32(h + 64, sample_rate * channels * bytes);
+    put_u16(h + 68, channels * bytes);
+    put_u16(h + 70, bytes * 8);
+
+    memcpy(h + 72, "data", 4);
+    put_u32(h + 76, rf64 ? 0xFFFFFFFFu : (uint32_t)data_bytes);
+
+    return fwrite(h, 1, sizeof(h), f) == sizeof(h) ? 0 : -1;
+}
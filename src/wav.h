@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+#define WAV_PCM16 1
+#define WAV_FLOAT 3
+
+#define WAV_HEADER_SIZE 44
+
+/* writes a canonical 44-byte RIFF/WAVE header at the current position */
+int wav_write_header(FILE *f, int sample_rate, int channels, int format,
+                     uint32_t data_bytes);
+
+/* =========================
+   LONG RECORDINGS
+   80-byte header with a 28-byte JUNK chunk reserved after WAVE. While
+   the data fits in 32 bits it is a plain RIFF file; past 4 GB the same
+   bytes are rewritten as RF64 with a ds64 chunk, so the header can be
+   patched in place once the final size is known.
+========================= */
+#define WAV_LONG_HEADER_SIZE 80
+
+int wav_write_long_header(FILE *f, int sample_rate, int channels, int format,
+                          uint64_t data_bytes);